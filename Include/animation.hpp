@@ -0,0 +1,273 @@
+#ifndef ANIMATION_HPP
+#define ANIMATION_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+
+namespace detail {
+
+// Interpolates channels begin to end between their current key and the next one. Keys are
+// gathered lane by lane, since every channel sits at a key of its own.
+template <int N, bool Normalize>
+struct interpolate_keys_kernel {
+    template <class V>
+    static void run(const float* times, const float* const* components, const uint32_t* channel_begins, const uint32_t* keys, float time, float* output, size_t begin, size_t end) {
+        for (size_t channel = begin; channel < end; channel += V::width) {
+            int lanes = end - channel < (size_t)V::width ? (int)(end - channel) : (int)V::width;
+
+            float weights[V::width] = { };
+            float lower[N][V::width] = { }, upper[N][V::width] = { };
+            for (int l = 0; l < lanes; l++) {
+                uint32_t key = keys[channel + l];
+                uint32_t next = key + 1 < channel_begins[channel + l + 1] ? key + 1 : key;
+                float span = times[next] - times[key];
+                weights[l] = span > 0.0f ? simd::min(simd::max((time - times[key]) / span, 0.0f), 1.0f) : 0.0f;
+                for (int c = 0; c < N; c++) {
+                    lower[c][l] = components[c][key];
+                    upper[c][l] = components[c][next];
+                }
+            }
+
+            V weight = V::load(weights);
+            V a[N], b[N];
+            for (int c = 0; c < N; c++) {
+                a[c] = V::load(lower[c]);
+                b[c] = V::load(upper[c]);
+            }
+
+            if (Normalize) {
+                V cosine = a[0] * b[0];
+                for (int c = 1; c < N; c++) cosine = fmadd(a[c], b[c], cosine);
+                V sign = cosine & V(-0.0f);
+                for (int c = 0; c < N; c++) b[c] = b[c] ^ sign;
+            }
+
+            V result[N];
+            for (int c = 0; c < N; c++) result[c] = fmadd(b[c] - a[c], weight, a[c]);
+
+            if (Normalize) {
+                V length_squared = result[0] * result[0];
+                for (int c = 1; c < N; c++) length_squared = fmadd(result[c], result[c], length_squared);
+                V inverse_length = rsqrt(length_squared);
+                for (int c = 0; c < N; c++) result[c] = result[c] * inverse_length;
+            }
+
+            for (int c = 0; c < N; c++) simd::store_strided(result[c], output + channel * N + c, N, lanes);
+        }
+    }
+};
+
+}
+
+// Playback state of one animation instance: the current key of every channel of a track and the
+// time it was last sampled at.
+struct animation_cursor {
+
+    std::vector<uint32_t> keys;
+    float time;
+
+    NEO_BATCH_FUNC_DECL animation_cursor(): time(0.0f) { }
+
+};
+
+// Keyframed channels of one value type (float, float2, float3 or float4). Keys of all channels are
+// stored back to back: times in one array and every value component in an array of its own.
+template <class T>
+class animation_track {
+
+public:
+
+    enum { COMPONENTS = sizeof(T) / sizeof(float) };
+
+    NEO_BATCH_FUNC_DECL animation_track(): channel_begins(1, 0) { }
+
+    // Needs at least one key, sorted by time, and throws std::invalid_argument without any; returns
+    // the index of the new channel.
+    NEO_BATCH_FUNC_DECL size_t add_channel(const float* key_times, const T* key_values, size_t count);
+
+    NEO_BATCH_FUNC_DECL size_t channel_count() const { return channel_begins.size() - 1; }
+    NEO_BATCH_FUNC_DECL float duration() const;
+
+    // Writes one value per channel. Times outside a channel's keys hold its first or last value.
+    NEO_BATCH_FUNC_DECL void sample(float time, animation_cursor& cursor, T* values) const;
+    // Normalized lerp along the shorter arc, for quaternion tracks.
+    NEO_BATCH_FUNC_DECL void sample_normalized(float time, animation_cursor& cursor, T* values) const;
+
+    // Samples count instances in parallel; instance i writes channel_count() values at values + i * channel_count().
+    NEO_BATCH_FUNC_DECL void sample(const float* playback_times, animation_cursor* cursors, T* values, size_t count) const;
+    NEO_BATCH_FUNC_DECL void sample_normalized(const float* playback_times, animation_cursor* cursors, T* values, size_t count) const;
+
+private:
+
+    std::vector<float> times;
+    std::vector<float> components[COMPONENTS];
+    std::vector<uint32_t> channel_begins;
+
+    NEO_BATCH_FUNC_DECL void seek(float time, animation_cursor& cursor) const;
+
+    template <bool Normalize>
+    void interpolate(float time, const animation_cursor& cursor, T* values) const;
+
+};
+
+template <class T>
+NEO_BATCH_FUNC_DEF size_t animation_track<T>::add_channel(const float* key_times, const T* key_values, size_t count) {
+    if (count == 0) throw std::invalid_argument("animation_track::add_channel: a channel needs at least one key");
+    times.insert(times.end(), key_times, key_times + count);
+    for (int c = 0; c < COMPONENTS; c++) {
+        for (size_t i = 0; i < count; i++) components[c].push_back(((const float*)(key_values + i))[c]);
+    }
+    channel_begins.push_back((uint32_t)times.size());
+    return channel_count() - 1;
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF float animation_track<T>::duration() const {
+    float result = 0.0f;
+    for (size_t i = 1; i < channel_begins.size(); i++) {
+        if (channel_begins[i] > channel_begins[i - 1]) result = simd::max(result, times[channel_begins[i] - 1]);
+    }
+    return result;
+}
+
+// Monotonic playback crosses at most one key per channel and frame, so one linear step is tried
+// before falling back to a binary search. Playing backwards restarts from the first keys.
+template <class T>
+NEO_BATCH_FUNC_DEF void animation_track<T>::seek(float time, animation_cursor& cursor) const {
+    size_t channels = channel_count();
+    if (cursor.keys.size() != channels || time < cursor.time) cursor.keys.assign(channel_begins.begin(), channel_begins.end() - 1);
+    cursor.time = time;
+
+    const float* first = times.data();
+    for (size_t channel = 0; channel < channels; channel++) {
+        uint32_t key = cursor.keys[channel];
+        uint32_t last = channel_begins[channel + 1] - 1;
+        if (key < last && first[key + 1] <= time) {
+            key++;
+            if (key < last && first[key + 1] <= time) key = (uint32_t)(std::upper_bound(first + key + 1, first + last + 1, time) - first) - 1;
+        }
+        cursor.keys[channel] = key;
+    }
+}
+
+template <class T>
+template <bool Normalize>
+inline void animation_track<T>::interpolate(float time, const animation_cursor& cursor, T* values) const {
+    const float* component_data[COMPONENTS];
+    for (int c = 0; c < COMPONENTS; c++) component_data[c] = components[c].data();
+    const float* const* component_pointers = component_data;
+    simd::dispatch<detail::interpolate_keys_kernel<COMPONENTS, Normalize> >(times.data(), component_pointers, channel_begins.data(), cursor.keys.data(), time, (float*)values, (size_t)0, channel_count());
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF void animation_track<T>::sample(float time, animation_cursor& cursor, T* values) const {
+    seek(time, cursor);
+    interpolate<false>(time, cursor, values);
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF void animation_track<T>::sample_normalized(float time, animation_cursor& cursor, T* values) const {
+    seek(time, cursor);
+    interpolate<true>(time, cursor, values);
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF void animation_track<T>::sample(const float* playback_times, animation_cursor* cursors, T* values, size_t count) const {
+    size_t channels = channel_count();
+    parallel_for(count, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) sample(playback_times[i], cursors[i], values + i * channels);
+    });
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF void animation_track<T>::sample_normalized(const float* playback_times, animation_cursor* cursors, T* values, size_t count) const {
+    size_t channels = channel_count();
+    parallel_for(count, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) sample_normalized(playback_times[i], cursors[i], values + i * channels);
+    });
+}
+
+namespace detail {
+
+// Accumulates every pose into one register block before storing, so the result is written once.
+struct blend_kernel {
+    template <class V>
+    static void run(const float* const* poses, const float* weights, size_t pose_count, float* result, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V sum(0.0f);
+            for (size_t p = 0; p < pose_count; p++) sum = fmadd(V(weights[p]), V::load(poses[p] + i, lanes), sum);
+            sum.store(result + i, lanes);
+        }
+    }
+};
+
+// Each rotation is flipped into the hemisphere of the first pose before the weighted sum is normalized.
+struct blend_rotations_kernel {
+    template <class V>
+    static void run(const float4* const* poses, const float* weights, size_t pose_count, float4* result, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V reference[4], sum[4];
+            for (int c = 0; c < 4; c++) {
+                reference[c] = simd::load_strided<V>(&poses[0][i].x + c, 4, lanes);
+                sum[c] = reference[c] * V(weights[0]);
+            }
+            for (size_t p = 1; p < pose_count; p++) {
+                V q[4];
+                for (int c = 0; c < 4; c++) q[c] = simd::load_strided<V>(&poses[p][i].x + c, 4, lanes);
+                V cosine = fmadd(reference[0], q[0], fmadd(reference[1], q[1], fmadd(reference[2], q[2], reference[3] * q[3])));
+                V weight = V(weights[p]) ^ (cosine & V(-0.0f));
+                for (int c = 0; c < 4; c++) sum[c] = fmadd(weight, q[c], sum[c]);
+            }
+            V inverse_length = rsqrt(fmadd(sum[0], sum[0], fmadd(sum[1], sum[1], fmadd(sum[2], sum[2], sum[3] * sum[3]))));
+            for (int c = 0; c < 4; c++) simd::store_strided(sum[c] * inverse_length, &result[i].x + c, 4, lanes);
+        }
+    }
+};
+
+inline void blend(const float* const* poses, const float* weights, size_t pose_count, float* result, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<blend_kernel>(poses, weights, pose_count, result, begin, end);
+    });
+}
+
+// Blends vector poses as flat float arrays through pointers to their first components.
+template <class T>
+inline void blend_vectors(const T* const* poses, const float* weights, size_t pose_count, T* result, size_t count) {
+    std::vector<const float*> components(pose_count);
+    for (size_t p = 0; p < pose_count; p++) components[p] = &poses[p]->x;
+    blend(components.data(), weights, pose_count, &result->x, count * (sizeof(T) / sizeof(float)));
+}
+
+}
+
+NEO_BATCH_FUNC_DEF void blend(const float* const* poses, const float* weights, size_t pose_count, float* result, size_t count) {
+    detail::blend(poses, weights, pose_count, result, count);
+}
+
+NEO_BATCH_FUNC_DEF void blend(const float3* const* poses, const float* weights, size_t pose_count, float3* result, size_t count) {
+    detail::blend_vectors(poses, weights, pose_count, result, count);
+}
+
+NEO_BATCH_FUNC_DEF void blend(const float4* const* poses, const float* weights, size_t pose_count, float4* result, size_t count) {
+    detail::blend_vectors(poses, weights, pose_count, result, count);
+}
+
+NEO_BATCH_FUNC_DEF void blend_rotations(const float4* const* poses, const float* weights, size_t pose_count, float4* result, size_t count) {
+    if (pose_count == 0) return;
+
+    parallel_for(count, 1 << 12, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::blend_rotations_kernel>(poses, weights, pose_count, result, begin, end);
+    });
+}
+
+}
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef BROADPHASE_HPP
+#define BROADPHASE_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+// Sorted arrays are padded past the last box with boxes that start at infinity, so sweeps load whole
+// registers; lanes past the last box are masked out, which also ends sweeps of unbounded boxes.
+const size_t SWEEP_PADDING = 16;
+
+// Maps floats to unsigned integers of the same order for radix sorting.
+inline uint32_t float_key(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits ^ ((uint32_t)((int32_t)bits >> 31) | 0x80000000u);
+}
+
+// Sorts keys and order together; gives up, leaving both partially sorted, once more than budget
+// elements have been moved.
+inline bool insertion_sort(float* keys, uint32_t* order, size_t count, size_t budget) {
+    size_t moves = 0;
+    for (size_t i = 1; i < count; i++) {
+        float key = keys[i];
+        uint32_t index = order[i];
+        size_t j = i;
+        for (; j > 0 && keys[j - 1] > key; j--) {
+            keys[j] = keys[j - 1];
+            order[j] = order[j - 1];
+        }
+        keys[j] = key;
+        order[j] = index;
+        moves += i - j;
+        if (moves > budget) return false;
+    }
+    return true;
+}
+
+// Box i is compared against the boxes that follow it in sweep order until one starts past its end.
+// The sweep axis bound and both remaining axes are tested for a register of candidates at once.
+struct sweep_kernel {
+    template <class V>
+    static void run(const float* const* sorted, const uint32_t* order, size_t count, std::vector<uint32_t>* pairs, size_t begin, size_t end) {
+        const float* sweep_lower = sorted[0];
+        const float* sweep_upper = sorted[1];
+        const int full = (1 << V::width) - 1;
+
+        for (size_t i = begin; i < end; i++) {
+            V reach = V(sweep_upper[i]);
+            V lower[2] = { V(sorted[2][i]), V(sorted[4][i]) };
+            V upper[2] = { V(sorted[3][i]), V(sorted[5][i]) };
+
+            for (size_t j = i + 1; j < count; j += V::width) {
+                int valid = count - j < (size_t)V::width ? (1 << (count - j)) - 1 : full;
+                V inside = V::load(sweep_lower + j) <= reach;
+                V overlap = inside;
+                for (int k = 0; k < 2; k++) {
+                    overlap = overlap & (V::load(sorted[2 + 2 * k] + j) <= upper[k]) & (V::load(sorted[3 + 2 * k] + j) >= lower[k]);
+                }
+                for (int bits = mask_bits(overlap) & valid; bits != 0; bits &= bits - 1) {
+                    int lane = 0;
+                    while (!(bits >> lane & 1)) lane++;
+                    uint32_t a = order[i], b = order[j + lane];
+                    pairs->push_back(a < b ? a : b);
+                    pairs->push_back(a < b ? b : a);
+                }
+                if (mask_bits(inside) != full) break;
+            }
+        }
+    }
+};
+
+}
+
+// Sort-and-sweep broadphase. Boxes are sorted by their lower bound along the axis on which box
+// centers vary most, and every box is swept against the boxes that start before it ends. The order
+// is kept between updates: when the boxes moved little it is repaired with an insertion sort,
+// otherwise, or when the sweep axis changes, it is rebuilt with a radix sort. Sweeps over ranges of
+// the sorted boxes run in parallel.
+class broadphase {
+
+public:
+
+    NEO_BATCH_FUNC_DECL broadphase(): axis(0) { }
+
+    // Replaces pairs with the overlapping boxes (closed intervals) as consecutive index pairs,
+    // the smaller index first.
+    NEO_BATCH_FUNC_DECL void update(const float3* lower, const float3* upper, size_t count, std::vector<uint32_t>& pairs);
+
+    NEO_BATCH_FUNC_DECL int sweep_axis() const { return axis; }
+
+private:
+
+    int axis;
+    std::vector<uint32_t> order, radix_keys;
+    std::vector<float> sorted[6];
+    std::vector<float3> centers;
+
+};
+
+NEO_BATCH_FUNC_DEF void broadphase::update(const float3* lower, const float3* upper, size_t count, std::vector<uint32_t>& pairs) {
+    const size_t grain = 1 << 14;
+
+    // Switching axes costs a full sort, so the current axis is kept unless another clearly varies more.
+    centers.resize(count);
+    parallel_for(count, grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) centers[i] = (lower[i] + upper[i]) * 0.5f;
+    });
+    float3x3 spread = covariance(centers.data(), count);
+    int widest = 0;
+    for (int c = 1; c < 3; c++) {
+        if (spread[c][c] > spread[widest][widest]) widest = c;
+    }
+    bool resort = order.size() != count;
+    if (spread[widest][widest] > 1.25f * spread[axis][axis]) {
+        resort = resort || widest != axis;
+        axis = widest;
+    }
+
+    for (int k = 0; k < 6; k++) sorted[k].resize(count + detail::SWEEP_PADDING);
+    float* keys = sorted[0].data();
+
+    if (!resort) {
+        parallel_for(count, grain, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++) keys[k] = lower[order[k]][axis];
+        });
+        resort = !detail::insertion_sort(keys, order.data(), count, count);
+    }
+    if (resort) {
+        order.resize(count);
+        radix_keys.resize(count);
+        parallel_for(count, grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                radix_keys[i] = detail::float_key(lower[i][axis]);
+                order[i] = (uint32_t)i;
+            }
+        });
+        radix_sort(radix_keys.data(), order.data(), count);
+    }
+
+    int first = (axis + 1) % 3, second = (axis + 2) % 3;
+    parallel_for(count, grain, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+            const float3& l = lower[order[k]];
+            const float3& u = upper[order[k]];
+            sorted[0][k] = l[axis];
+            sorted[1][k] = u[axis];
+            sorted[2][k] = l[first];
+            sorted[3][k] = u[first];
+            sorted[4][k] = l[second];
+            sorted[5][k] = u[second];
+        }
+    });
+    for (int k = 0; k < 6; k++) std::fill(sorted[k].begin() + count, sorted[k].end(), k == 0 ? std::numeric_limits<float>::infinity() : 0.0f);
+
+    const size_t sweep_grain = 1 << 11;
+    size_t blocks = (count + sweep_grain - 1) / sweep_grain;
+    std::vector<std::vector<uint32_t> > block_pairs(blocks);
+    const float* columns[6];
+    for (int k = 0; k < 6; k++) columns[k] = sorted[k].data();
+    parallel_for(count, sweep_grain, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::sweep_kernel>((const float* const*)columns, (const uint32_t*)order.data(), count, &block_pairs[begin / sweep_grain], begin, end);
+    });
+
+    std::vector<size_t> offsets(blocks + 1, 0);
+    for (size_t b = 0; b < blocks; b++) offsets[b + 1] = offsets[b] + block_pairs[b].size();
+    pairs.resize(offsets[blocks]);
+    parallel_for(blocks, 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) std::copy(block_pairs[b].begin(), block_pairs[b].end(), pairs.begin() + offsets[b]);
+    });
+}
+
+}
+
+#endif
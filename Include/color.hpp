@@ -0,0 +1,248 @@
+#ifndef COLOR_HPP
+#define COLOR_HPP
+
+#include <stdint.h>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace simd {
+
+// log2 of a positive, normal x: the exponent plus a degree 6 polynomial in the mantissa, absolute
+// error below 2.5e-6.
+template <class V>
+inline V log2(const V& x) {
+    typedef typename V::int_type I;
+
+    I bits = as_int(x);
+    V exponent = to_float((bits >> 23) - I(127));
+    V t = as_float((bits & I(0x007FFFFF)) | I(0x3F800000)) - V(1.0f);
+    V p = fmadd(V(-0.025792335f), t, V(0.121472918f));
+    p = fmadd(p, t, V(-0.277341612f));
+    p = fmadd(p, t, V(0.457158104f));
+    p = fmadd(p, t, V(-0.718033587f));
+    p = fmadd(p, t, V(1.44253478f));
+    return fmadd(p, t, exponent);
+}
+
+// 2^x for x in [-126, 128): the integer part goes into the exponent and a degree 5 polynomial
+// gives the fraction, relative error below 1.2e-7.
+template <class V>
+inline V exp2(const V& x) {
+    V integer = floor(x);
+    V t = x - integer;
+    V p = fmadd(V(0.00188540406f), t, V(0.00897289862f));
+    p = fmadd(p, t, V(0.0558365986f));
+    p = fmadd(p, t, V(0.240152444f));
+    p = fmadd(p, t, V(0.693152535f));
+    p = fmadd(p, t, V(1.0f));
+    return as_float(as_int(p) + (to_int(integer) << 23));
+}
+
+// Piecewise sRGB transfer functions with the power segment evaluated as exp2(log2(x) * exponent);
+// results are within 5e-6 relative of the exact curves. Values above 1 follow the power segment.
+template <class V>
+inline V srgb_to_linear(const V& x) {
+    V curve = exp2(log2(max(fmadd(x, V(1.0f / 1.055f), V(0.055f / 1.055f)), V(1e-30f))) * V(2.4f));
+    return select(x <= V(0.04045f), x * V(1.0f / 12.92f), curve);
+}
+
+template <class V>
+inline V linear_to_srgb(const V& x) {
+    V curve = fmadd(exp2(log2(max(x, V(1e-30f))) * V(1.0f / 2.4f)), V(1.055f), V(-0.055f));
+    return select(x <= V(0.0031308f), x * V(12.92f), curve);
+}
+
+}
+
+namespace detail {
+
+enum color_conversion { SRGB_TO_LINEAR, LINEAR_TO_SRGB, RGB_TO_YCOCG, YCOCG_TO_RGB, RGB_TO_HSV, HSV_TO_RGB };
+
+// Converts the first three of components floats per pixel, passing alpha through. Input and output
+// may be the same array.
+struct color_kernel {
+    template <class V>
+    static void run(const float* input, float* output, int components, color_conversion type, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V c[4];
+            simd::load_interleaved(input + i * components, c, components, lanes);
+
+            switch (type) {
+            case SRGB_TO_LINEAR:
+                for (int k = 0; k < 3; k++) c[k] = simd::srgb_to_linear(c[k]);
+                break;
+            case LINEAR_TO_SRGB:
+                for (int k = 0; k < 3; k++) c[k] = simd::linear_to_srgb(c[k]);
+                break;
+            case RGB_TO_YCOCG: {
+                V half_rb = (c[0] + c[2]) * V(0.5f);
+                V y = (half_rb + c[1]) * V(0.5f);
+                V co = (c[0] - c[2]) * V(0.5f);
+                V cg = (c[1] - half_rb) * V(0.5f);
+                c[0] = y;
+                c[1] = co;
+                c[2] = cg;
+                break;
+            }
+            case YCOCG_TO_RGB: {
+                V base = c[0] - c[2];
+                V g = c[0] + c[2];
+                c[0] = base + c[1];
+                c[2] = base - c[1];
+                c[1] = g;
+                break;
+            }
+            case RGB_TO_HSV: {
+                V maximum = max(c[0], max(c[1], c[2]));
+                V delta = maximum - min(c[0], min(c[1], c[2]));
+                V inverse_delta = V(1.0f) / select(delta == V(0.0f), V(1.0f), delta);
+                V hue = select(maximum == c[0], (c[1] - c[2]) * inverse_delta,
+                        select(maximum == c[1], fmadd(c[2] - c[0], inverse_delta, V(2.0f)), fmadd(c[0] - c[1], inverse_delta, V(4.0f))));
+                hue = hue * V(1.0f / 6.0f);
+                hue = hue + (V(1.0f) & (hue < V(0.0f)));
+                hue = andnot(hue >= V(1.0f), hue);
+                c[1] = delta / select(maximum == V(0.0f), V(1.0f), maximum);
+                c[0] = hue;
+                c[2] = maximum;
+                break;
+            }
+            case HSV_TO_RGB: {
+                // Channel n is v - v s clamp(min(k, 4 - k), 0, 1) with k = (n + 6 h) mod 6, for n
+                // of 5, 3 and 1.
+                V sector = (c[0] - floor(c[0])) * V(6.0f);
+                V chroma = c[2] * c[1], value = c[2];
+                for (int k = 0; k < 3; k++) {
+                    V position = sector + V((float)(5 - 2 * k));
+                    position = position - (V(6.0f) & (position >= V(6.0f)));
+                    c[k] = fnmadd(chroma, min(max(min(position, V(4.0f) - position), V(0.0f)), V(1.0f)), value);
+                }
+                break;
+            }
+            }
+            simd::store_interleaved(c, output + i * components, components, lanes);
+        }
+    }
+};
+
+// RGBA8 words hold red in the lowest byte, so they are R, G, B, A bytes in memory on little-endian
+// hosts. Channels are clamped to [0, 1] and rounded to the nearest step.
+struct pack_rgba8_kernel {
+    template <class V>
+    static void run(const float* colors, uint32_t* packed, bool srgb, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V c[4];
+            simd::load_interleaved(colors + i * 4, c, 4, lanes);
+            I code = I(0);
+            for (int k = 0; k < 4; k++) {
+                V channel = srgb && k < 3 ? simd::linear_to_srgb(c[k]) : c[k];
+                channel = min(max(channel, V(0.0f)), V(1.0f)) * V(255.0f);
+                code = code | round_to_int(channel) << (8 * k);
+            }
+            if (lanes == V::width) code.store(packed + i);
+            else code.store(packed + i, lanes);
+        }
+    }
+};
+
+struct unpack_rgba8_kernel {
+    template <class V>
+    static void run(const uint32_t* packed, float* colors, bool srgb, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            I code = lanes == V::width ? I::load(packed + i) : I::load(packed + i, lanes);
+            V c[4];
+            for (int k = 0; k < 4; k++) {
+                c[k] = to_float(code >> (8 * k) & I(255)) * V(1.0f / 255.0f);
+                if (srgb && k < 3) c[k] = simd::srgb_to_linear(c[k]);
+            }
+            simd::store_interleaved(c, colors + i * 4, 4, lanes);
+        }
+    }
+};
+
+inline void convert_colors(const float* input, float* output, int components, size_t count, color_conversion type) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<color_kernel>(input, output, components, type, begin, end);
+    });
+}
+
+}
+
+// Conversions between sRGB-encoded and linear colors; float4 alpha is passed through. Input and
+// output may be the same array.
+NEO_BATCH_FUNC_DEF void srgb_to_linear(const float3* colors, float3* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 3, count, detail::SRGB_TO_LINEAR);
+}
+
+NEO_BATCH_FUNC_DEF void srgb_to_linear(const float4* colors, float4* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 4, count, detail::SRGB_TO_LINEAR);
+}
+
+NEO_BATCH_FUNC_DEF void linear_to_srgb(const float3* colors, float3* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 3, count, detail::LINEAR_TO_SRGB);
+}
+
+NEO_BATCH_FUNC_DEF void linear_to_srgb(const float4* colors, float4* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 4, count, detail::LINEAR_TO_SRGB);
+}
+
+// YCoCg as (Y, Co, Cg): Y in [0, 1] and the chroma in [-0.5, 0.5] for RGB in [0, 1]. The transform
+// is exact up to float rounding.
+NEO_BATCH_FUNC_DEF void rgb_to_ycocg(const float3* colors, float3* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 3, count, detail::RGB_TO_YCOCG);
+}
+
+NEO_BATCH_FUNC_DEF void rgb_to_ycocg(const float4* colors, float4* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 4, count, detail::RGB_TO_YCOCG);
+}
+
+NEO_BATCH_FUNC_DEF void ycocg_to_rgb(const float3* colors, float3* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 3, count, detail::YCOCG_TO_RGB);
+}
+
+NEO_BATCH_FUNC_DEF void ycocg_to_rgb(const float4* colors, float4* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 4, count, detail::YCOCG_TO_RGB);
+}
+
+// HSV as (hue, saturation, value) with hue in [0, 1); gray has hue and saturation 0.
+NEO_BATCH_FUNC_DEF void rgb_to_hsv(const float3* colors, float3* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 3, count, detail::RGB_TO_HSV);
+}
+
+NEO_BATCH_FUNC_DEF void rgb_to_hsv(const float4* colors, float4* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 4, count, detail::RGB_TO_HSV);
+}
+
+NEO_BATCH_FUNC_DEF void hsv_to_rgb(const float3* colors, float3* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 3, count, detail::HSV_TO_RGB);
+}
+
+NEO_BATCH_FUNC_DEF void hsv_to_rgb(const float4* colors, float4* result, size_t count) {
+    detail::convert_colors(&colors[0].x, &result[0].x, 4, count, detail::HSV_TO_RGB);
+}
+
+// Packing to and from 8 bit RGBA, sRGB-encoding the color channels of linear input when srgb is
+// set. Packing after the approximate curve picks the same 8 bit value as the exact one except at
+// rounding ties.
+NEO_BATCH_FUNC_DEF void pack_rgba8(const float4* colors, uint32_t* packed, size_t count, bool srgb = true) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::pack_rgba8_kernel>(&colors[0].x, packed, srgb, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void unpack_rgba8(const uint32_t* packed, float4* colors, size_t count, bool srgb = true) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::unpack_rgba8_kernel>(packed, &colors[0].x, srgb, begin, end);
+    });
+}
+
+}
+
+#endif
@@ -0,0 +1,546 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+// Smallest-three quaternions: q and -q are the same rotation, so the sign is chosen to make the
+// largest component positive and only the other three, each within +-1/sqrt(2), are stored with
+// 10 bits next to the 2 bit index of the dropped one. The stored components are within half a step,
+// sqrt(2) / 1023 / 2 = 6.9e-4, of the input; the dropped one is rebuilt from them and gathers their
+// errors, so decoded components are within about 1.9e-3 and rotations within about 0.26 degrees.
+const float ROTATION_RANGE = 0.70710678f;
+const float ROTATION_STEPS = 1023.0f;
+
+struct encode_rotations_kernel {
+    template <class V>
+    static void run(const float* rotations, uint32_t* codes, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+
+        V scale = V(0.5f * ROTATION_STEPS / ROTATION_RANGE);
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V q[4];
+            simd::load_interleaved(rotations + i * 4, q, 4, lanes);
+
+            V largest = abs(q[0]), index = V(0.0f);
+            for (int c = 1; c < 4; c++) {
+                V larger = abs(q[c]) > largest;
+                largest = max(largest, abs(q[c]));
+                index = select(larger, V((float)c), index);
+            }
+            V sign = V(0.0f);
+            for (int c = 0; c < 4; c++) sign = select(index == V((float)c), q[c] & V(-0.0f), sign);
+
+            I code = to_int(index) << 30;
+            for (int s = 0; s < 3; s++) {
+                V value = select(index <= V((float)s), q[s + 1], q[s]) ^ sign;
+                V steps = min(max(fmadd(value, scale, V(0.5f * ROTATION_STEPS)), V(0.0f)), V(ROTATION_STEPS));
+                code = code | round_to_int(steps) << (20 - 10 * s);
+            }
+            if (lanes == V::width) code.store(codes + i);
+            else code.store(codes + i, lanes);
+        }
+    }
+};
+
+struct decode_rotations_kernel {
+    template <class V>
+    static void run(const uint32_t* codes, float* rotations, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+
+        V scale = V(ROTATION_RANGE * 2.0f / ROTATION_STEPS);
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            I code = lanes == V::width ? I::load(codes + i) : I::load(codes + i, lanes);
+
+            V index = to_float(code >> 30);
+            V r[3], sum = V(0.0f);
+            for (int s = 0; s < 3; s++) {
+                r[s] = fmadd(to_float(code >> (20 - 10 * s) & I(1023)), scale, V(-ROTATION_RANGE));
+                sum = fmadd(r[s], r[s], sum);
+            }
+            V largest = sqrt(max(V(1.0f) - sum, V(0.0f)));
+
+            // Component c is the dropped one, or stored value c - 1 or c depending on where the
+            // dropped one sits.
+            V q[4];
+            for (int c = 0; c < 4; c++) {
+                V stored = c == 0 ? r[0] : c == 3 ? r[2] : select(index < V((float)c), r[c - 1], r[c]);
+                q[c] = select(index == V((float)c), largest, stored);
+            }
+            V inverse_length = rsqrt(fmadd(q[0], q[0], fmadd(q[1], q[1], fmadd(q[2], q[2], q[3] * q[3]))));
+            for (int c = 0; c < 4; c++) q[c] = q[c] * inverse_length;
+            simd::store_interleaved(q, rotations + i * 4, 4, lanes);
+        }
+    }
+};
+
+// Components are mapped linearly from [lower, upper] to 16 bit steps; values outside are clamped.
+const float VECTOR_STEPS = 65535.0f;
+
+// Codes are widened to and narrowed from a float block of interleaved components, which keeps the
+// conversions to contiguous loops and the transposes in registers.
+struct quantize_kernel {
+    template <class V>
+    static void run(const float* vectors, float3 lower, float3 upper, uint16_t* codes, size_t begin, size_t end) {
+        V offset[3], scale[3];
+        for (int c = 0; c < 3; c++) {
+            float extent = upper[c] - lower[c];
+            offset[c] = V(lower[c]);
+            scale[c] = V(extent > 0.0f ? VECTOR_STEPS / extent : 0.0f);
+        }
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V v[3];
+            simd::load_interleaved(vectors + i * 3, v, 3, lanes);
+            for (int c = 0; c < 3; c++) v[c] = to_float(round_to_int(min(max((v[c] - offset[c]) * scale[c], V(0.0f)), V(VECTOR_STEPS))));
+            float steps[3 * V::width];
+            simd::store_interleaved(v, steps, 3, lanes);
+            for (int k = 0; k < 3 * lanes; k++) codes[i * 3 + k] = (uint16_t)steps[k];
+        }
+    }
+};
+
+struct dequantize_kernel {
+    template <class V>
+    static void run(const uint16_t* codes, float3 lower, float3 upper, float* vectors, size_t begin, size_t end) {
+        V offset[3], step[3];
+        for (int c = 0; c < 3; c++) {
+            offset[c] = V(lower[c]);
+            step[c] = V((upper[c] - lower[c]) / VECTOR_STEPS);
+        }
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            float steps[3 * V::width];
+            for (int k = 0; k < 3 * lanes; k++) steps[k] = codes[i * 3 + k];
+            V v[3];
+            simd::load_interleaved(steps, v, 3, lanes);
+            for (int c = 0; c < 3; c++) v[c] = fmadd(v[c], step[c], offset[c]);
+            simd::store_interleaved(v, vectors + i * 3, 3, lanes);
+        }
+    }
+};
+
+// Column-major translation * rotation * scale.
+struct compose_kernel {
+    template <class V>
+    static void run(const float* translations, const float* rotations, const float* scales, float* matrices, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V t[3], q[4], s[3];
+            simd::load_interleaved(translations + i * 3, t, 3, lanes);
+            simd::load_interleaved(rotations + i * 4, q, 4, lanes);
+            if (scales != nullptr) simd::load_interleaved(scales + i * 3, s, 3, lanes);
+            else s[0] = s[1] = s[2] = V(1.0f);
+
+            V x2 = q[0] + q[0], y2 = q[1] + q[1], z2 = q[2] + q[2];
+            V xx = q[0] * x2, yy = q[1] * y2, zz = q[2] * z2;
+            V xy = q[0] * y2, xz = q[0] * z2, yz = q[1] * z2;
+            V wx = q[3] * x2, wy = q[3] * y2, wz = q[3] * z2;
+            V one = V(1.0f), zero = V(0.0f);
+
+            V m[16] = {
+                (one - yy - zz) * s[0], (xy + wz) * s[0], (xz - wy) * s[0], zero,
+                (xy - wz) * s[1], (one - xx - zz) * s[1], (yz + wx) * s[1], zero,
+                (xz + wy) * s[2], (yz - wx) * s[2], (one - xx - yy) * s[2], zero,
+                t[0], t[1], t[2], one
+            };
+            simd::store_interleaved(m, matrices + i * 16, 16, lanes);
+        }
+    }
+};
+
+const uint8_t TRANSFORM_STREAM_MAGIC[4] = { 'N', 'E', 'O', 'T' };
+const uint8_t TRANSFORM_STREAM_VERSION = 1;
+const size_t TRANSFORM_BLOCK = 1 << 12;
+const int TRANSFORM_FIELDS = 10;
+
+// Quantized frame: one rotation code and three position and scale steps per transform.
+struct transform_codes {
+
+    std::vector<uint32_t> rotations;
+    std::vector<uint16_t> positions, scales;
+
+    void resize(size_t count) {
+        rotations.resize(count);
+        positions.resize(count * 3);
+        scales.resize(count * 3);
+    }
+
+    size_t size() const { return rotations.size(); }
+
+    bool same(size_t i, const transform_codes& other) const {
+        return rotations[i] == other.rotations[i] && std::memcmp(&positions[i * 3], &other.positions[i * 3], 6) == 0 && std::memcmp(&scales[i * 3], &other.scales[i * 3], 6) == 0;
+    }
+
+    void copy(size_t i, const transform_codes& other) {
+        rotations[i] = other.rotations[i];
+        std::memcpy(&positions[i * 3], &other.positions[i * 3], 6);
+        std::memcpy(&scales[i * 3], &other.scales[i * 3], 6);
+    }
+
+    void get(size_t i, uint32_t* fields) const {
+        uint32_t rotation = rotations[i];
+        fields[0] = rotation >> 30;
+        for (int s = 0; s < 3; s++) fields[1 + s] = rotation >> (20 - 10 * s) & 1023;
+        for (int c = 0; c < 3; c++) {
+            fields[4 + c] = positions[i * 3 + c];
+            fields[7 + c] = scales[i * 3 + c];
+        }
+    }
+
+    void set(size_t i, const uint32_t* fields) {
+        rotations[i] = fields[0] << 30 | fields[1] << 20 | fields[2] << 10 | fields[3];
+        for (int c = 0; c < 3; c++) {
+            positions[i * 3 + c] = (uint16_t)fields[4 + c];
+            scales[i * 3 + c] = (uint16_t)fields[7 + c];
+        }
+    }
+
+};
+
+inline bool transform_fields_valid(const uint32_t* fields) {
+    if (fields[0] > 3) return false;
+    for (int f = 1; f < 4; f++) {
+        if (fields[f] > 1023) return false;
+    }
+    for (int f = 4; f < TRANSFORM_FIELDS; f++) {
+        if (fields[f] > 65535) return false;
+    }
+    return true;
+}
+
+inline void append_varint(std::vector<uint8_t>& bytes, uint32_t value) {
+    for (; value >= 0x80; value >>= 7) bytes.push_back((uint8_t)(value | 0x80));
+    bytes.push_back((uint8_t)value);
+}
+
+inline bool read_varint(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (p >= end) return false;
+        uint8_t byte = *p++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint32_t zigzag(uint32_t value, uint32_t reference) {
+    int32_t delta = (int32_t)(value - reference);
+    return (uint32_t)delta << 1 ^ (uint32_t)(delta >> 31);
+}
+
+inline uint32_t unzigzag(uint32_t encoded, uint32_t reference) {
+    return reference + (encoded >> 1 ^ (0u - (encoded & 1)));
+}
+
+// A block is a bitmap of the transforms whose codes differ from the reference, followed by the
+// zigzag-encoded field differences of those transforms as varints. Keyframes use a zero reference.
+inline void encode_transform_block(const transform_codes& codes, const transform_codes* reference, size_t begin, size_t end, std::vector<uint8_t>& bytes) {
+    bytes.assign((end - begin + 7) / 8, 0);
+    uint32_t fields[TRANSFORM_FIELDS], base[TRANSFORM_FIELDS] = { 0 };
+    for (size_t i = begin; i < end; i++) {
+        if (reference != nullptr && codes.same(i, *reference)) continue;
+        codes.get(i, fields);
+        if (reference != nullptr) reference->get(i, base);
+        if (std::memcmp(fields, base, sizeof(fields)) == 0) continue;
+        bytes[(i - begin) / 8] |= (uint8_t)(1 << (i - begin) % 8);
+        for (int f = 0; f < TRANSFORM_FIELDS; f++) append_varint(bytes, zigzag(fields[f], base[f]));
+    }
+}
+
+inline bool decode_transform_block(const uint8_t* p, const uint8_t* end, const transform_codes* reference, size_t begin, size_t last, transform_codes& codes) {
+    const uint8_t* changed = p;
+    p += (last - begin + 7) / 8;
+    if (p > end) return false;
+    uint32_t fields[TRANSFORM_FIELDS], base[TRANSFORM_FIELDS] = { 0 };
+    for (size_t i = begin; i < last; i++) {
+        bool stored = changed[(i - begin) / 8] >> (i - begin) % 8 & 1;
+        if (!stored) {
+            if (reference != nullptr) codes.copy(i, *reference);
+            else codes.set(i, base);
+            continue;
+        }
+        if (reference != nullptr) reference->get(i, base);
+        for (int f = 0; f < TRANSFORM_FIELDS; f++) {
+            uint32_t encoded;
+            if (!read_varint(p, end, encoded)) return false;
+            fields[f] = unzigzag(encoded, base[f]);
+        }
+        if (!transform_fields_valid(fields)) return false;
+        codes.set(i, fields);
+    }
+    return p == end;
+}
+
+}
+
+// Smallest-three rotation codes, 32 bits per unit quaternion; decoded quaternions are normalized
+// and have a non-negative largest component.
+NEO_BATCH_FUNC_DEF void encode_rotations(const float4* rotations, uint32_t* codes, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::encode_rotations_kernel>(&rotations[0].x, codes, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void decode_rotations(const uint32_t* codes, float4* rotations, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::decode_rotations_kernel>(codes, &rotations[0].x, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF uint32_t encode_rotation(const float4& rotation) {
+    uint32_t code;
+    simd::dispatch<detail::encode_rotations_kernel>(&rotation.x, &code, (size_t)0, (size_t)1);
+    return code;
+}
+
+NEO_BATCH_FUNC_DEF float4 decode_rotation(uint32_t code) {
+    float4 rotation;
+    simd::dispatch<detail::decode_rotations_kernel>((const uint32_t*)&code, &rotation.x, (size_t)0, (size_t)1);
+    return rotation;
+}
+
+// Three 16 bit steps per vector within [lower, upper]; dequantized components are within about
+// (upper - lower) / 131070 of the input.
+NEO_BATCH_FUNC_DEF void quantize(const float3* vectors, const float3& lower, const float3& upper, uint16_t* codes, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::quantize_kernel>(&vectors[0].x, lower, upper, codes, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void dequantize(const uint16_t* codes, const float3& lower, const float3& upper, float3* vectors, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::dequantize_kernel>(codes, lower, upper, &vectors[0].x, begin, end);
+    });
+}
+
+// Matrices from translation, rotation and scale; scales may be null for unit scale.
+NEO_BATCH_FUNC_DEF void compose(const float3* translations, const float4* rotations, const float3* scales, float4x4* matrices, size_t count) {
+    const float* scale_data = scales != nullptr ? &scales[0].x : nullptr;
+    parallel_for(count, 1 << 13, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::compose_kernel>(&translations[0].x, &rotations[0].x, scale_data, &matrices[0].c0.x, begin, end);
+    });
+}
+
+// Records frames of transforms as quantized translations, rotations and scales (16 bytes per
+// transform before entropy coding, against 64 for a float4x4). Every keyframe_interval frames, and
+// whenever the transform count changes, a frame is stored whole; the others store the difference
+// of the quantized values from the previous frame, which is exact, so errors do not accumulate.
+// Blocks of transforms are encoded and decoded in parallel. The stream starts with the
+// quantization bounds in host byte order. The default scale range [0, 65535 / 16384] has a step of
+// exactly 2^-14, so unit scales decode exactly.
+class transform_writer {
+
+public:
+
+    NEO_BATCH_FUNC_DECL transform_writer(const float3& position_lower, const float3& position_upper, const float3& scale_lower = float3(0.0f), const float3& scale_upper = float3(65535.0f / 16384.0f), size_t keyframe_interval = 60);
+
+    // Scales may be null for unit scale. Matrices are decomposed first, so they have to be
+    // translation * rotation * scale without shear.
+    NEO_BATCH_FUNC_DECL void write(const float3* translations, const float4* rotations, const float3* scales, size_t count);
+    NEO_BATCH_FUNC_DECL void write(const float4x4* matrices, size_t count);
+
+    // Bytes recorded since construction or the last clear or take.
+    NEO_BATCH_FUNC_DECL const std::vector<uint8_t>& data() const { return bytes; }
+    // Moves the recorded bytes into chunk, replacing its contents. Later frames are still encoded
+    // against the last one, so the chunks taken in order concatenate to one stream.
+    NEO_BATCH_FUNC_DECL void take(std::vector<uint8_t>& chunk);
+    // Drops the recorded frames; the next frame starts a new stream.
+    NEO_BATCH_FUNC_DECL void clear();
+
+private:
+
+    float3 bounds[4];
+    size_t interval, frames;
+    std::vector<uint8_t> bytes;
+    detail::transform_codes current, previous;
+    std::vector<std::vector<uint8_t> > blocks;
+    std::vector<float3> unpacked_translations, unpacked_scales;
+    std::vector<float4> unpacked_rotations;
+
+};
+
+class transform_reader {
+
+public:
+
+    // The data has to outlive the reader. valid is false if it does not start a transform stream.
+    NEO_BATCH_FUNC_DECL transform_reader(const uint8_t* data, size_t size);
+
+    NEO_BATCH_FUNC_DECL bool valid() const { return position != nullptr; }
+    NEO_BATCH_FUNC_DECL bool end() const { return position == nullptr || position == last; }
+    // Transform count of the next frame.
+    NEO_BATCH_FUNC_DECL size_t next_count() const;
+
+    // Decodes the next frame into arrays of next_count() elements; scales may be null. Returns
+    // false at the end of the stream or if the frame is malformed, which ends the stream.
+    NEO_BATCH_FUNC_DECL bool read(float3* translations, float4* rotations, float3* scales);
+    NEO_BATCH_FUNC_DECL bool read(float4x4* matrices);
+
+private:
+
+    float3 bounds[4];
+    const uint8_t* position;
+    const uint8_t* last;
+    detail::transform_codes current, previous;
+    std::vector<float3> unpacked_translations, unpacked_scales;
+    std::vector<float4> unpacked_rotations;
+
+    NEO_BATCH_FUNC_DECL bool decode();
+
+};
+
+NEO_BATCH_FUNC_DEF transform_writer::transform_writer(const float3& position_lower, const float3& position_upper, const float3& scale_lower, const float3& scale_upper, size_t keyframe_interval):
+    interval(keyframe_interval > 0 ? keyframe_interval : 1), frames(0) {
+    bounds[0] = position_lower;
+    bounds[1] = position_upper;
+    bounds[2] = scale_lower;
+    bounds[3] = scale_upper;
+}
+
+NEO_BATCH_FUNC_DEF void transform_writer::clear() {
+    bytes.clear();
+    frames = 0;
+}
+
+NEO_BATCH_FUNC_DEF void transform_writer::take(std::vector<uint8_t>& chunk) {
+    chunk.clear();
+    chunk.swap(bytes);
+}
+
+NEO_BATCH_FUNC_DEF void transform_writer::write(const float3* translations, const float4* rotations, const float3* scales, size_t count) {
+    if (frames == 0) {
+        bytes.insert(bytes.end(), detail::TRANSFORM_STREAM_MAGIC, detail::TRANSFORM_STREAM_MAGIC + 4);
+        bytes.push_back(detail::TRANSFORM_STREAM_VERSION);
+        size_t offset = bytes.size();
+        bytes.resize(offset + sizeof(bounds));
+        std::memcpy(&bytes[offset], bounds, sizeof(bounds));
+    }
+
+    current.resize(count);
+    encode_rotations(rotations, current.rotations.data(), count);
+    quantize(translations, bounds[0], bounds[1], current.positions.data(), count);
+    if (scales != nullptr) {
+        quantize(scales, bounds[2], bounds[3], current.scales.data(), count);
+    } else {
+        unpacked_scales.assign(count, float3(1.0f));
+        quantize(unpacked_scales.data(), bounds[2], bounds[3], current.scales.data(), count);
+    }
+
+    bool keyframe = frames % interval == 0 || previous.size() != count;
+    const detail::transform_codes* reference = keyframe ? nullptr : &previous;
+    size_t block_count = (count + detail::TRANSFORM_BLOCK - 1) / detail::TRANSFORM_BLOCK;
+    blocks.resize(block_count);
+    parallel_for(block_count, 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            size_t first = b * detail::TRANSFORM_BLOCK;
+            size_t last = first + detail::TRANSFORM_BLOCK < count ? first + detail::TRANSFORM_BLOCK : count;
+            detail::encode_transform_block(current, reference, first, last, blocks[b]);
+        }
+    });
+
+    detail::append_varint(bytes, (uint32_t)count);
+    bytes.push_back(keyframe ? 1 : 0);
+    for (size_t b = 0; b < block_count; b++) detail::append_varint(bytes, (uint32_t)blocks[b].size());
+    for (size_t b = 0; b < block_count; b++) bytes.insert(bytes.end(), blocks[b].begin(), blocks[b].end());
+
+    std::swap(current, previous);
+    frames++;
+}
+
+NEO_BATCH_FUNC_DEF void transform_writer::write(const float4x4* matrices, size_t count) {
+    unpacked_translations.resize(count);
+    unpacked_rotations.resize(count);
+    unpacked_scales.resize(count);
+    parallel_for(count, 1 << 13, [&](size_t begin, size_t end) {
+        decompose(matrices + begin, &unpacked_translations[begin], &unpacked_rotations[begin], &unpacked_scales[begin], end - begin);
+    });
+    write(unpacked_translations.data(), unpacked_rotations.data(), unpacked_scales.data(), count);
+}
+
+NEO_BATCH_FUNC_DEF transform_reader::transform_reader(const uint8_t* data, size_t size): position(nullptr), last(data + size) {
+    if (size < 5 + sizeof(bounds)) return;
+    if (std::memcmp(data, detail::TRANSFORM_STREAM_MAGIC, 4) != 0 || data[4] != detail::TRANSFORM_STREAM_VERSION) return;
+    std::memcpy(bounds, data + 5, sizeof(bounds));
+    position = data + 5 + sizeof(bounds);
+}
+
+NEO_BATCH_FUNC_DEF size_t transform_reader::next_count() const {
+    const uint8_t* p = position;
+    uint32_t count;
+    if (end() || !detail::read_varint(p, last, count)) return 0;
+    return count;
+}
+
+NEO_BATCH_FUNC_DEF bool transform_reader::decode() {
+    const uint8_t* p = position;
+    uint32_t count;
+    if (end() || !detail::read_varint(p, last, count) || p >= last) return false;
+    bool keyframe = *p++ != 0;
+    if (!keyframe && previous.size() != count) return false;
+
+    size_t block_count = (count + detail::TRANSFORM_BLOCK - 1) / detail::TRANSFORM_BLOCK;
+    std::vector<const uint8_t*> offsets(block_count + 1);
+    std::vector<uint32_t> sizes(block_count);
+    for (size_t b = 0; b < block_count; b++) {
+        if (!detail::read_varint(p, last, sizes[b])) return false;
+    }
+    offsets[0] = p;
+    for (size_t b = 0; b < block_count; b++) {
+        if (sizes[b] > (size_t)(last - offsets[b])) return false;
+        offsets[b + 1] = offsets[b] + sizes[b];
+    }
+
+    current.resize(count);
+    const detail::transform_codes* reference = keyframe ? nullptr : &previous;
+    std::vector<char> failed(block_count, 0);
+    parallel_for(block_count, 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            size_t first = b * detail::TRANSFORM_BLOCK;
+            size_t last_transform = first + detail::TRANSFORM_BLOCK < count ? first + detail::TRANSFORM_BLOCK : (size_t)count;
+            failed[b] = !detail::decode_transform_block(offsets[b], offsets[b + 1], reference, first, last_transform, current);
+        }
+    });
+    for (size_t b = 0; b < block_count; b++) {
+        if (failed[b]) return false;
+    }
+
+    std::swap(current, previous);
+    position = offsets[block_count];
+    return true;
+}
+
+NEO_BATCH_FUNC_DEF bool transform_reader::read(float3* translations, float4* rotations, float3* scales) {
+    if (!decode()) {
+        position = last;
+        return false;
+    }
+    size_t count = previous.size();
+    decode_rotations(previous.rotations.data(), rotations, count);
+    dequantize(previous.positions.data(), bounds[0], bounds[1], translations, count);
+    if (scales != nullptr) dequantize(previous.scales.data(), bounds[2], bounds[3], scales, count);
+    return true;
+}
+
+NEO_BATCH_FUNC_DEF bool transform_reader::read(float4x4* matrices) {
+    size_t count = next_count();
+    unpacked_translations.resize(count);
+    unpacked_rotations.resize(count);
+    unpacked_scales.resize(count);
+    if (!read(unpacked_translations.data(), unpacked_rotations.data(), unpacked_scales.data())) return false;
+    compose(unpacked_translations.data(), unpacked_rotations.data(), unpacked_scales.data(), matrices, count);
+    return true;
+}
+
+}
+
+#endif
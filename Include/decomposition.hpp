@@ -0,0 +1,409 @@
+#ifndef DECOMPOSITION_HPP
+#define DECOMPOSITION_HPP
+
+#include "neo.hpp"
+
+namespace neo {
+namespace simd {
+
+// Branch-free 3x3 decompositions after McAdams et al., "Computing the Singular Value Decomposition
+// of 3x3 matrices with minimal branching and elementary floating point operations". Every kernel is
+// written once for T = float and for SIMD lanes; matrices are nine column-major scalars.
+
+const int JACOBI_SWEEPS = 5;
+
+// Sorts key[i] and key[j] into descending order and reports which lanes were swapped.
+template <class T>
+NEO_FUNC_DEF auto sort_pair(T* key, int i, int j) -> decltype(key[i] < key[j]) {
+    auto swap = key[i] < key[j];
+    T temp = select(swap, key[j], key[i]);
+    key[j] = select(swap, key[i], key[j]);
+    key[i] = temp;
+    return swap;
+}
+
+// Swaps columns i and j where requested, negating the new column j so that the determinant is kept.
+template <class T, class M>
+NEO_FUNC_DEF void swap_columns(const M& swap, T* m, int i, int j) {
+    for (int r = 0; r < 3; r++) {
+        T a = m[3 * i + r], b = m[3 * j + r];
+        m[3 * i + r] = select(swap, b, a);
+        m[3 * j + r] = select(swap, -a, b);
+    }
+}
+
+// Approximate Jacobi rotation from the half-angle estimate, clamped to pi/4 where the estimate is poor.
+template <int p, int q, class T>
+NEO_FUNC_DEF void jacobi_rotation(T* s, T* v) {
+    const int k = 3 - p - q;
+
+    T spp = s[4 * p], sqq = s[4 * q], spq = s[3 * q + p], spk = s[3 * k + p], sqk = s[3 * k + q];
+
+    // Off-diagonal entries below float precision are flushed so that later sweeps never go denormal.
+    auto negligible = spq * spq <= T(1.0e-14f) * fmadd(spp, spp, sqq * sqq);
+    T ch = select(negligible, T(1.0f), spp - sqq);
+    T sh = select(negligible, T(0.0f), spq * T(0.5f));
+
+    T scale = rsqrt(fmadd(ch, ch, sh * sh));
+    ch = ch * scale;
+    sh = sh * scale;
+
+    auto steep = ch * ch < T(5.82842712f) * sh * sh;
+    ch = select(steep, T(0.92387953f), ch);
+    sh = select(steep, T(0.38268343f), sh);
+
+    T c = fnmadd(sh, sh, ch * ch);
+    T sn = T(2.0f) * sh * ch;
+
+    T cc = c * c, ss = sn * sn, cs = c * sn;
+
+    s[4 * p] = cc * spp + T(2.0f) * cs * spq + ss * sqq;
+    s[4 * q] = ss * spp - T(2.0f) * cs * spq + cc * sqq;
+    s[3 * q + p] = s[3 * p + q] = select(negligible, T(0.0f), (cc - ss) * spq - cs * (spp - sqq));
+    s[3 * k + p] = s[3 * p + k] = c * spk + sn * sqk;
+    s[3 * k + q] = s[3 * q + k] = c * sqk - sn * spk;
+
+    for (int r = 0; r < 3; r++) {
+        T vp = v[3 * p + r], vq = v[3 * q + r];
+        v[3 * p + r] = c * vp + sn * vq;
+        v[3 * q + r] = c * vq - sn * vp;
+    }
+}
+
+template <class T>
+NEO_FUNC_DEF void jacobi_eigen(T* s, T* v) {
+    for (int i = 0; i < 9; i++) v[i] = T(i % 4 == 0 ? 1.0f : 0.0f);
+    for (int sweep = 0; sweep < JACOBI_SWEEPS; sweep++) {
+        jacobi_rotation<0, 1>(s, v);
+        jacobi_rotation<0, 2>(s, v);
+        jacobi_rotation<1, 2>(s, v);
+    }
+}
+
+// Rotates rows i and j of b so that b[j][i] becomes zero and accumulates the rotation into q.
+template <int i, int j, class T>
+NEO_FUNC_DEF void givens_qr(T* b, T* q) {
+    T a = b[3 * i + i], d = b[3 * i + j];
+    T length_squared = fmadd(a, a, d * d);
+    auto degenerate = length_squared < T(1.0e-37f);
+    T scale = rsqrt(select(degenerate, T(1.0f), length_squared));
+    T c = select(degenerate, T(1.0f), a * scale);
+    T sn = select(degenerate, T(0.0f), d * scale);
+
+    for (int column = 0; column < 3; column++) {
+        T bi = b[3 * column + i], bj = b[3 * column + j];
+        b[3 * column + i] = c * bi + sn * bj;
+        b[3 * column + j] = c * bj - sn * bi;
+    }
+    for (int r = 0; r < 3; r++) {
+        T qi = q[3 * i + r], qj = q[3 * j + r];
+        q[3 * i + r] = c * qi + sn * qj;
+        q[3 * j + r] = c * qj - sn * qi;
+    }
+}
+
+// Eigenvalues in descending order; the eigenvectors form a rotation.
+template <class T>
+NEO_FUNC_DEF void symmetric_eigen(const T* a, T* values, T* vectors) {
+    T s[9];
+    for (int i = 0; i < 9; i++) s[i] = a[i];
+    jacobi_eigen(s, vectors);
+
+    values[0] = s[0];
+    values[1] = s[4];
+    values[2] = s[8];
+    swap_columns(sort_pair(values, 0, 1), vectors, 0, 1);
+    swap_columns(sort_pair(values, 0, 2), vectors, 0, 2);
+    swap_columns(sort_pair(values, 1, 2), vectors, 1, 2);
+}
+
+// a = u * diag(sigma) * v^T with u and v rotations. Singular values are sorted by decreasing
+// magnitude and the last one carries the sign of det(a).
+template <class T>
+NEO_FUNC_DEF void svd(const T* a, T* u, T* sigma, T* v) {
+    T s[9];
+    for (int column = 0; column < 3; column++) {
+        for (int row = column; row < 3; row++) {
+            T dot = a[3 * row] * a[3 * column] + a[3 * row + 1] * a[3 * column + 1] + a[3 * row + 2] * a[3 * column + 2];
+            s[3 * column + row] = s[3 * row + column] = dot;
+        }
+    }
+    jacobi_eigen(s, v);
+
+    T b[9];
+    for (int column = 0; column < 3; column++) {
+        for (int row = 0; row < 3; row++) {
+            b[3 * column + row] = a[row] * v[3 * column] + a[3 + row] * v[3 * column + 1] + a[6 + row] * v[3 * column + 2];
+        }
+    }
+
+    T norms[3];
+    for (int column = 0; column < 3; column++) {
+        norms[column] = b[3 * column] * b[3 * column] + b[3 * column + 1] * b[3 * column + 1] + b[3 * column + 2] * b[3 * column + 2];
+    }
+    for (int i = 0; i < 2; i++) {
+        for (int j = i + 1; j < 3; j++) {
+            auto swap = sort_pair(norms, i, j);
+            swap_columns(swap, b, i, j);
+            swap_columns(swap, v, i, j);
+        }
+    }
+
+    for (int i = 0; i < 9; i++) u[i] = T(i % 4 == 0 ? 1.0f : 0.0f);
+    givens_qr<0, 1>(b, u);
+    givens_qr<0, 2>(b, u);
+    givens_qr<1, 2>(b, u);
+
+    sigma[0] = b[0];
+    sigma[1] = b[4];
+    sigma[2] = b[8];
+}
+
+// a = rotation * stretch with stretch symmetric; rotation stays proper when det(a) < 0.
+template <class T>
+NEO_FUNC_DEF void polar(const T* a, T* rotation, T* stretch) {
+    T u[9], sigma[3], v[9];
+    svd(a, u, sigma, v);
+    for (int column = 0; column < 3; column++) {
+        for (int row = 0; row < 3; row++) {
+            rotation[3 * column + row] = u[row] * v[column] + u[3 + row] * v[3 + column] + u[6 + row] * v[6 + column];
+            stretch[3 * column + row] = v[row] * sigma[0] * v[column] + v[3 + row] * sigma[1] * v[3 + column] + v[6 + row] * sigma[2] * v[6 + column];
+        }
+    }
+}
+
+// Shepperd's method with the pivot chosen by selects: the largest of the four trace combinations.
+template <class T>
+NEO_FUNC_DEF void quaternion_from_rotation(const T* r, T* q) {
+    T m00 = r[0], m10 = r[1], m20 = r[2], m01 = r[3], m11 = r[4], m21 = r[5], m02 = r[6], m12 = r[7], m22 = r[8];
+
+    T tw = T(1.0f) + m00 + m11 + m22;
+    T tx = T(1.0f) + m00 - m11 - m22;
+    T ty = T(1.0f) - m00 + m11 - m22;
+    T tz = T(1.0f) - m00 - m11 + m22;
+
+    T qx = m21 - m12, qy = m02 - m20, qz = m10 - m01, qw = tw, t = tw;
+
+    auto pick_x = tx > t;
+    qx = select(pick_x, tx, qx);
+    qy = select(pick_x, m10 + m01, qy);
+    qz = select(pick_x, m02 + m20, qz);
+    qw = select(pick_x, m21 - m12, qw);
+    t = select(pick_x, tx, t);
+
+    auto pick_y = ty > t;
+    qx = select(pick_y, m10 + m01, qx);
+    qy = select(pick_y, ty, qy);
+    qz = select(pick_y, m21 + m12, qz);
+    qw = select(pick_y, m02 - m20, qw);
+    t = select(pick_y, ty, t);
+
+    auto pick_z = tz > t;
+    qx = select(pick_z, m02 + m20, qx);
+    qy = select(pick_z, m21 + m12, qy);
+    qz = select(pick_z, tz, qz);
+    qw = select(pick_z, m10 - m01, qw);
+    t = select(pick_z, tz, t);
+
+    T scale = T(0.5f) * rsqrt(t);
+    q[0] = qx * scale;
+    q[1] = qy * scale;
+    q[2] = qz * scale;
+    q[3] = qw * scale;
+}
+
+// Splits an affine translation * rotation * scale matrix given as four column-major xyz columns.
+// Shear is not recovered; a reflection is attributed to the x axis. A zero-length column gets scale
+// 0 and the matching identity column in the rotation, so degenerate matrices decompose to finite
+// values.
+template <class T>
+NEO_FUNC_DEF void decompose(const T* m, T* translation, T* rotation, T* scale) {
+    for (int i = 0; i < 3; i++) {
+        translation[i] = m[9 + i];
+        scale[i] = sqrt(m[3 * i] * m[3 * i] + m[3 * i + 1] * m[3 * i + 1] + m[3 * i + 2] * m[3 * i + 2]);
+    }
+
+    T det = m[0] * (m[4] * m[8] - m[5] * m[7]) + m[1] * (m[5] * m[6] - m[3] * m[8]) + m[2] * (m[3] * m[7] - m[4] * m[6]);
+    scale[0] = select(det < T(0.0f), -scale[0], scale[0]);
+
+    for (int i = 0; i < 3; i++) {
+        auto degenerate = scale[i] == T(0.0f);
+        T inverse_scale = T(1.0f) / select(degenerate, T(1.0f), scale[i]);
+        for (int r = 0; r < 3; r++) rotation[3 * i + r] = select(degenerate, T(r == i ? 1.0f : 0.0f), m[3 * i + r] * inverse_scale);
+    }
+}
+
+template <class V>
+inline void load_float3x3(const float3x3* matrices, V* lanes, int count = V::width) {
+    for (int i = 0; i < 9; i++) lanes[i] = load_strided<V>(&matrices->c0.x + i, 9, count);
+}
+
+template <class V>
+inline void store_float3x3(const V* lanes, float3x3* matrices, int count = V::width) {
+    for (int i = 0; i < 9; i++) store_strided(lanes[i], &matrices->c0.x + i, 9, count);
+}
+
+template <class V>
+inline void store_float3(const V* lanes, float3* vectors, int count = V::width) {
+    for (int i = 0; i < 3; i++) store_strided(lanes[i], &vectors->x + i, 3, count);
+}
+
+template <class V>
+inline void load_float4x4_affine(const float4x4* matrices, V* lanes, int count = V::width) {
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 3; row++) lanes[3 * column + row] = load_strided<V>(&matrices->c0.x + 4 * column + row, 16, count);
+    }
+}
+
+template <class V>
+inline void store_float4(const V* lanes, float4* vectors, int count = V::width) {
+    for (int i = 0; i < 4; i++) store_strided(lanes[i], &vectors->x + i, 4, count);
+}
+
+}
+
+NEO_FUNC_DEF void float3x3::symmetric_eigen(float3& values, float3x3& vectors) const {
+    float a[9] = { c0.x, c0.y, c0.z, c1.x, c1.y, c1.z, c2.x, c2.y, c2.z };
+    float l[3], v[9];
+    simd::symmetric_eigen(a, l, v);
+    values = float3(l[0], l[1], l[2]);
+    vectors = float3x3(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8]);
+}
+
+NEO_FUNC_DEF void float3x3::svd(float3x3& u, float3& sigma, float3x3& v) const {
+    float a[9] = { c0.x, c0.y, c0.z, c1.x, c1.y, c1.z, c2.x, c2.y, c2.z };
+    float lu[9], ls[3], lv[9];
+    simd::svd(a, lu, ls, lv);
+    u = float3x3(lu[0], lu[1], lu[2], lu[3], lu[4], lu[5], lu[6], lu[7], lu[8]);
+    sigma = float3(ls[0], ls[1], ls[2]);
+    v = float3x3(lv[0], lv[1], lv[2], lv[3], lv[4], lv[5], lv[6], lv[7], lv[8]);
+}
+
+NEO_FUNC_DEF void float3x3::polar(float3x3& rotation, float3x3& stretch) const {
+    float a[9] = { c0.x, c0.y, c0.z, c1.x, c1.y, c1.z, c2.x, c2.y, c2.z };
+    float r[9], s[9];
+    simd::polar(a, r, s);
+    rotation = float3x3(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8]);
+    stretch = float3x3(s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7], s[8]);
+}
+
+NEO_FUNC_DEF void float4x4::decompose(float3& translation, float3x3& rotation, float3& scale) const {
+    float m[12] = { c0.x, c0.y, c0.z, c1.x, c1.y, c1.z, c2.x, c2.y, c2.z, c3.x, c3.y, c3.z };
+    float t[3], r[9], s[3];
+    simd::decompose(m, t, r, s);
+    translation = float3(t[0], t[1], t[2]);
+    rotation = float3x3(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8]);
+    scale = float3(s[0], s[1], s[2]);
+}
+
+NEO_FUNC_DEF void float4x4::decompose(float3& translation, float4& rotation, float3& scale) const {
+    float m[12] = { c0.x, c0.y, c0.z, c1.x, c1.y, c1.z, c2.x, c2.y, c2.z, c3.x, c3.y, c3.z };
+    float t[3], r[9], s[3], q[4];
+    simd::decompose(m, t, r, s);
+    simd::quaternion_from_rotation(r, q);
+    translation = float3(t[0], t[1], t[2]);
+    rotation = float4(q[0], q[1], q[2], q[3]);
+    scale = float3(s[0], s[1], s[2]);
+}
+
+namespace detail {
+
+struct symmetric_eigen_kernel {
+    template <class V>
+    static void run(const float3x3* matrices, float3* values, float3x3* vectors, size_t count) {
+        for (size_t i = 0; i < count; i += V::width) {
+            int lanes = count - i < (size_t)V::width ? (int)(count - i) : (int)V::width;
+            V a[9], l[3], v[9];
+            simd::load_float3x3(matrices + i, a, lanes);
+            simd::symmetric_eigen(a, l, v);
+            simd::store_float3(l, values + i, lanes);
+            simd::store_float3x3(v, vectors + i, lanes);
+        }
+    }
+};
+
+struct svd_kernel {
+    template <class V>
+    static void run(const float3x3* matrices, float3x3* u, float3* sigma, float3x3* v, size_t count) {
+        for (size_t i = 0; i < count; i += V::width) {
+            int lanes = count - i < (size_t)V::width ? (int)(count - i) : (int)V::width;
+            V a[9], lu[9], ls[3], lv[9];
+            simd::load_float3x3(matrices + i, a, lanes);
+            simd::svd(a, lu, ls, lv);
+            simd::store_float3x3(lu, u + i, lanes);
+            simd::store_float3(ls, sigma + i, lanes);
+            simd::store_float3x3(lv, v + i, lanes);
+        }
+    }
+};
+
+struct polar_kernel {
+    template <class V>
+    static void run(const float3x3* matrices, float3x3* rotations, float3x3* stretches, size_t count) {
+        for (size_t i = 0; i < count; i += V::width) {
+            int lanes = count - i < (size_t)V::width ? (int)(count - i) : (int)V::width;
+            V a[9], r[9], s[9];
+            simd::load_float3x3(matrices + i, a, lanes);
+            simd::polar(a, r, s);
+            simd::store_float3x3(r, rotations + i, lanes);
+            simd::store_float3x3(s, stretches + i, lanes);
+        }
+    }
+};
+
+struct decompose_matrix_kernel {
+    template <class V>
+    static void run(const float4x4* matrices, float3* translations, float3x3* rotations, float3* scales, size_t count) {
+        for (size_t i = 0; i < count; i += V::width) {
+            int lanes = count - i < (size_t)V::width ? (int)(count - i) : (int)V::width;
+            V m[12], t[3], r[9], s[3];
+            simd::load_float4x4_affine(matrices + i, m, lanes);
+            simd::decompose(m, t, r, s);
+            simd::store_float3(t, translations + i, lanes);
+            simd::store_float3x3(r, rotations + i, lanes);
+            simd::store_float3(s, scales + i, lanes);
+        }
+    }
+};
+
+struct decompose_quaternion_kernel {
+    template <class V>
+    static void run(const float4x4* matrices, float3* translations, float4* rotations, float3* scales, size_t count) {
+        for (size_t i = 0; i < count; i += V::width) {
+            int lanes = count - i < (size_t)V::width ? (int)(count - i) : (int)V::width;
+            V m[12], t[3], r[9], s[3], q[4];
+            simd::load_float4x4_affine(matrices + i, m, lanes);
+            simd::decompose(m, t, r, s);
+            simd::quaternion_from_rotation(r, q);
+            simd::store_float3(t, translations + i, lanes);
+            simd::store_float4(q, rotations + i, lanes);
+            simd::store_float3(s, scales + i, lanes);
+        }
+    }
+};
+
+}
+
+NEO_BATCH_FUNC_DEF void symmetric_eigen(const float3x3* matrices, float3* values, float3x3* vectors, size_t count) {
+    simd::dispatch<detail::symmetric_eigen_kernel>(matrices, values, vectors, count);
+}
+
+NEO_BATCH_FUNC_DEF void svd(const float3x3* matrices, float3x3* u, float3* sigma, float3x3* v, size_t count) {
+    simd::dispatch<detail::svd_kernel>(matrices, u, sigma, v, count);
+}
+
+NEO_BATCH_FUNC_DEF void polar(const float3x3* matrices, float3x3* rotations, float3x3* stretches, size_t count) {
+    simd::dispatch<detail::polar_kernel>(matrices, rotations, stretches, count);
+}
+
+NEO_BATCH_FUNC_DEF void decompose(const float4x4* matrices, float3* translations, float3x3* rotations, float3* scales, size_t count) {
+    simd::dispatch<detail::decompose_matrix_kernel>(matrices, translations, rotations, scales, count);
+}
+
+NEO_BATCH_FUNC_DEF void decompose(const float4x4* matrices, float3* translations, float4* rotations, float3* scales, size_t count) {
+    simd::dispatch<detail::decompose_quaternion_kernel>(matrices, translations, rotations, scales, count);
+}
+
+}
+
+#endif
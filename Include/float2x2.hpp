@@ -121,6 +121,99 @@ NEO_FUNC_DEF const float2& float2x2::operator[](int index) const {
     return columns[index];
 }
 
+namespace detail {
+
+struct det2x2_kernel {
+    template <class V>
+    static void run(const float2x2* matrices, float* determinants, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V m[4];
+            simd::load_interleaved(&matrices[i].c0.x, m, 4, lanes);
+            fnmadd(m[1], m[2], m[0] * m[3]).store(determinants + i, lanes);
+        }
+    }
+};
+
+struct inverse2x2_kernel {
+    template <class V>
+    static void run(const float2x2* matrices, float2x2* inverses, bool* singular, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V m[4];
+            simd::load_interleaved(&matrices[i].c0.x, m, 4, lanes);
+            V det = fnmadd(m[1], m[2], m[0] * m[3]);
+            V inverse_det = V(1.0f) / det;
+            V inv[4] = { m[3] * inverse_det, -m[1] * inverse_det, -m[2] * inverse_det, m[0] * inverse_det };
+            simd::store_interleaved(inv, &inverses[i].c0.x, 4, lanes);
+
+            if (singular != nullptr) {
+                V lengths = fmadd(m[0], m[0], m[1] * m[1]) * fmadd(m[2], m[2], m[3] * m[3]);
+                int flags = mask_bits(abs(det) <= V(1e-6f) * sqrt(lengths));
+                for (int l = 0; l < lanes; l++) singular[i + l] = (flags >> l & 1) != 0;
+            }
+        }
+    }
+};
+
+struct multiply2x2_kernel {
+    template <class V>
+    static void run(const float2x2* lhs, const float2x2* rhs, float2x2* products, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V a[4], b[4], p[4];
+            simd::load_interleaved(&lhs[i].c0.x, a, 4, lanes);
+            simd::load_interleaved(&rhs[i].c0.x, b, 4, lanes);
+            for (int column = 0; column < 2; column++) {
+                for (int row = 0; row < 2; row++) p[2 * column + row] = fmadd(a[row], b[2 * column], a[2 + row] * b[2 * column + 1]);
+            }
+            simd::store_interleaved(p, &products[i].c0.x, 4, lanes);
+        }
+    }
+};
+
+struct transform2x2_kernel {
+    template <class V>
+    static void run(const float2x2* matrices, const float2* vectors, float2* products, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V m[4], v[2];
+            simd::load_interleaved(&matrices[i].c0.x, m, 4, lanes);
+            simd::load_interleaved(&vectors[i].x, v, 2, lanes);
+            V p[2] = { fmadd(m[0], v[0], m[2] * v[1]), fmadd(m[1], v[0], m[3] * v[1]) };
+            simd::store_interleaved(p, &products[i].x, 2, lanes);
+        }
+    }
+};
+
+}
+
+NEO_BATCH_FUNC_DEF void det(const float2x2* matrices, float* determinants, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::det2x2_kernel>(matrices, determinants, begin, end);
+    });
+}
+
+// Matches float2x2::inverse; singular (which may be null) flags determinants below 1e-6 times the
+// product of the column lengths.
+NEO_BATCH_FUNC_DEF void inverse(const float2x2* matrices, float2x2* inverses, bool* singular, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::inverse2x2_kernel>(matrices, inverses, singular, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void multiply(const float2x2* lhs, const float2x2* rhs, float2x2* products, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::multiply2x2_kernel>(lhs, rhs, products, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void multiply(const float2x2* matrices, const float2* vectors, float2* products, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::transform2x2_kernel>(matrices, vectors, products, begin, end);
+    });
+}
+
 }
 
 #endif
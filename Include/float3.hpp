@@ -13,6 +13,24 @@ NEO_FUNC_DEF float4 float3::as_float4(float w) const {
     return float4(x, y, z, w);
 }
 
+template <int X, int Y>
+NEO_FUNC_DEF float2 float3::swizzle() const {
+    static_assert(X >= 0 && X < 3 && Y >= 0 && Y < 3, "swizzle index out of range");
+    return float2(scalars[X], scalars[Y]);
+}
+
+template <int X, int Y, int Z>
+NEO_FUNC_DEF float3 float3::swizzle() const {
+    static_assert(X >= 0 && X < 3 && Y >= 0 && Y < 3 && Z >= 0 && Z < 3, "swizzle index out of range");
+    return float3(scalars[X], scalars[Y], scalars[Z]);
+}
+
+template <int X, int Y, int Z, int W>
+NEO_FUNC_DEF float4 float3::swizzle() const {
+    static_assert(X >= 0 && X < 3 && Y >= 0 && Y < 3 && Z >= 0 && Z < 3 && W >= 0 && W < 3, "swizzle index out of range");
+    return float4(scalars[X], scalars[Y], scalars[Z], scalars[W]);
+}
+
 NEO_FUNC_DEF float float3::length() const {
     return sqrtf(dot(*this, *this));
 }
@@ -41,6 +41,13 @@ NEO_FUNC_DEF float3x3 float3x3::inverse() const {
     return inv / det;
 }
 
+// Transpose of the adjugate, i.e. det() * inverse().transpose(). Used as a normal matrix it needs
+// no divide and stays finite for singular matrices; normals flip with mirroring transforms, as the
+// winding of transformed triangles does.
+NEO_FUNC_DEF float3x3 float3x3::cofactor() const {
+    return float3x3(cross(c1, c2), cross(c2, c0), cross(c0, c1));
+}
+
 NEO_FUNC_DEF float float3x3::det() const {
     return c0.x * (c1.y * c2.z - c1.z * c2.y) + c0.y * (c1.z * c2.x - c1.x * c2.z) + c0.z * (c1.x * c2.y - c1.y * c2.x);
 }
@@ -137,6 +144,177 @@ NEO_FUNC_DEF const float3& float3x3::operator[](int index) const {
     return columns[index];
 }
 
+namespace detail {
+
+struct det3x3_kernel {
+    template <class V>
+    static void run(const float3x3* matrices, float* determinants, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V m[9];
+            simd::load_interleaved(&matrices[i].c0.x, m, 9, lanes);
+            V det = fmadd(m[0], fnmadd(m[5], m[7], m[4] * m[8]), fmadd(m[1], fnmadd(m[3], m[8], m[5] * m[6]), m[2] * fnmadd(m[4], m[6], m[3] * m[7])));
+            det.store(determinants + i, lanes);
+        }
+    }
+};
+
+struct inverse3x3_kernel {
+    template <class V>
+    static void run(const float3x3* matrices, float3x3* inverses, bool* singular, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V m[9];
+            simd::load_interleaved(&matrices[i].c0.x, m, 9, lanes);
+
+            V inv[9];
+            inv[0] = fnmadd(m[5], m[7], m[4] * m[8]);
+            inv[1] = fnmadd(m[1], m[8], m[2] * m[7]);
+            inv[2] = fnmadd(m[2], m[4], m[1] * m[5]);
+            inv[3] = fnmadd(m[3], m[8], m[5] * m[6]);
+            inv[4] = fnmadd(m[2], m[6], m[0] * m[8]);
+            inv[5] = fnmadd(m[0], m[5], m[2] * m[3]);
+            inv[6] = fnmadd(m[4], m[6], m[3] * m[7]);
+            inv[7] = fnmadd(m[0], m[7], m[1] * m[6]);
+            inv[8] = fnmadd(m[1], m[3], m[0] * m[4]);
+
+            V det = fmadd(m[0], inv[0], fmadd(m[1], inv[3], m[2] * inv[6]));
+            V inverse_det = V(1.0f) / det;
+            for (int j = 0; j < 9; j++) inv[j] = inv[j] * inverse_det;
+            simd::store_interleaved(inv, &inverses[i].c0.x, 9, lanes);
+
+            if (singular != nullptr) {
+                V lengths = V(1.0f);
+                for (int column = 0; column < 3; column++) {
+                    const V* c = m + 3 * column;
+                    lengths = lengths * fmadd(c[0], c[0], fmadd(c[1], c[1], c[2] * c[2]));
+                }
+                int flags = mask_bits(abs(det) <= V(1e-6f) * sqrt(lengths));
+                for (int l = 0; l < lanes; l++) singular[i + l] = (flags >> l & 1) != 0;
+            }
+        }
+    }
+};
+
+struct multiply3x3_kernel {
+    template <class V>
+    static void run(const float3x3* lhs, const float3x3* rhs, float3x3* products, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V a[9], b[9], p[9];
+            simd::load_interleaved(&lhs[i].c0.x, a, 9, lanes);
+            simd::load_interleaved(&rhs[i].c0.x, b, 9, lanes);
+            for (int column = 0; column < 3; column++) {
+                const V* c = b + 3 * column;
+                for (int row = 0; row < 3; row++) p[3 * column + row] = fmadd(a[row], c[0], fmadd(a[3 + row], c[1], a[6 + row] * c[2]));
+            }
+            simd::store_interleaved(p, &products[i].c0.x, 9, lanes);
+        }
+    }
+};
+
+struct transform3x3_kernel {
+    template <class V>
+    static void run(const float3x3* matrices, const float3* vectors, float3* products, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V m[9], v[3], p[3];
+            simd::load_interleaved(&matrices[i].c0.x, m, 9, lanes);
+            simd::load_interleaved(&vectors[i].x, v, 3, lanes);
+            for (int row = 0; row < 3; row++) p[row] = fmadd(m[row], v[0], fmadd(m[3 + row], v[1], m[6 + row] * v[2]));
+            simd::store_interleaved(p, &products[i].x, 3, lanes);
+        }
+    }
+};
+
+// Where the following normal is in range, normals move four floats at a time. The spare float is
+// the next normal's x as read, so writing it back is harmless even when transforming in place.
+struct transform_normals_kernel {
+    template <class V>
+    static void run(float3x3 matrix, const float3* normals, float3* transformed, size_t begin, size_t end) {
+        V m[9];
+        for (int k = 0; k < 9; k++) m[k] = V(matrix[k / 3][k % 3]);
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V v[4], p[4];
+            if (i + V::width < end) load_transposed4(&normals[i].x, 3, v);
+            else simd::load_interleaved(&normals[i].x, v, 3, lanes);
+            for (int row = 0; row < 3; row++) p[row] = fmadd(m[row], v[0], fmadd(m[3 + row], v[1], m[6 + row] * v[2]));
+            V inverse_length = rsqrt(fmadd(p[0], p[0], fmadd(p[1], p[1], p[2] * p[2])));
+            for (int row = 0; row < 3; row++) p[row] = p[row] * inverse_length;
+            if (i + V::width < end) {
+                p[3] = v[3];
+                store_transposed4(p, &transformed[i].x, 3);
+            } else {
+                simd::store_interleaved(p, &transformed[i].x, 3, lanes);
+            }
+        }
+    }
+};
+
+struct transform_normals3x3_kernel {
+    template <class V>
+    static void run(const float3x3* matrices, const float3* normals, float3* transformed, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V m[9], v[4], p[4];
+            simd::load_interleaved(&matrices[i].c0.x, m, 9, lanes);
+            if (i + V::width < end) load_transposed4(&normals[i].x, 3, v);
+            else simd::load_interleaved(&normals[i].x, v, 3, lanes);
+            for (int row = 0; row < 3; row++) p[row] = fmadd(m[row], v[0], fmadd(m[3 + row], v[1], m[6 + row] * v[2]));
+            V inverse_length = rsqrt(fmadd(p[0], p[0], fmadd(p[1], p[1], p[2] * p[2])));
+            for (int row = 0; row < 3; row++) p[row] = p[row] * inverse_length;
+            if (i + V::width < end) {
+                p[3] = v[3];
+                store_transposed4(p, &transformed[i].x, 3);
+            } else {
+                simd::store_interleaved(p, &transformed[i].x, 3, lanes);
+            }
+        }
+    }
+};
+
+}
+
+NEO_BATCH_FUNC_DEF void det(const float3x3* matrices, float* determinants, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::det3x3_kernel>(matrices, determinants, begin, end);
+    });
+}
+
+// Matches float3x3::inverse; singular (which may be null) flags determinants below 1e-6 times the
+// product of the column lengths.
+NEO_BATCH_FUNC_DEF void inverse(const float3x3* matrices, float3x3* inverses, bool* singular, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::inverse3x3_kernel>(matrices, inverses, singular, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void multiply(const float3x3* lhs, const float3x3* rhs, float3x3* products, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::multiply3x3_kernel>(lhs, rhs, products, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void multiply(const float3x3* matrices, const float3* vectors, float3* products, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::transform3x3_kernel>(matrices, vectors, products, begin, end);
+    });
+}
+
+// Multiplies by matrix, typically a normal matrix, and renormalizes. Normals may be transformed in place.
+NEO_BATCH_FUNC_DEF void transform_normals(const float3x3& matrix, const float3* normals, float3* transformed, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::transform_normals_kernel>(matrix, normals, transformed, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void transform_normals(const float3x3* matrices, const float3* normals, float3* transformed, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::transform_normals3x3_kernel>(matrices, normals, transformed, begin, end);
+    });
+}
+
 }
 
 #endif
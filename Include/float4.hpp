@@ -13,6 +13,31 @@ NEO_FUNC_DEF float3 float4::as_float3() const {
     return float3(x, y, z);
 }
 
+template <int X, int Y>
+NEO_FUNC_DEF float2 float4::swizzle() const {
+    static_assert(X >= 0 && X < 4 && Y >= 0 && Y < 4, "swizzle index out of range");
+    return float2(scalars[X], scalars[Y]);
+}
+
+template <int X, int Y, int Z>
+NEO_FUNC_DEF float3 float4::swizzle() const {
+    static_assert(X >= 0 && X < 4 && Y >= 0 && Y < 4 && Z >= 0 && Z < 4, "swizzle index out of range");
+    return float3(scalars[X], scalars[Y], scalars[Z]);
+}
+
+// A full float4 is one register, so its permutations are a single shuffle.
+template <int X, int Y, int Z, int W>
+NEO_FUNC_DEF float4 float4::swizzle() const {
+    static_assert(X >= 0 && X < 4 && Y >= 0 && Y < 4 && Z >= 0 && Z < 4 && W >= 0 && W < 4, "swizzle index out of range");
+#if NEO_SIMD >= NEO_SIMD_SSE2
+    float4 result;
+    simd::sse2::shuffle<X, Y, Z, W>(simd::sse2::floatv::load(scalars)).store(result.scalars);
+    return result;
+#else
+    return float4(scalars[X], scalars[Y], scalars[Z], scalars[W]);
+#endif
+}
+
 NEO_FUNC_DEF float float4::length() const {
     return sqrtf(dot(*this, *this));
 }
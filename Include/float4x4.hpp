@@ -23,22 +23,18 @@ NEO_FUNC_DEF float4x4 float4x4::translation(const float3& vector) {
     );
 }
 
-NEO_FUNC_DEF float4x4 float4x4::rotation(const float3& vector, float angle) {
-    float c = std::cos(angle);
-    float s = std::sin(angle);
+namespace detail {
 
+NEO_FUNC_DEF float4x4 rotation(const float3& vector, float c, float s) {
     return float4x4(
         float4(c + (1 - c) * vector.x * vector.x, (1 - c) * vector.x * vector.y + s * vector.z, (1 - c) * vector.x * vector.z - s * vector.y, 0.0f),
         float4((1 - c) * vector.x * vector.y - s * vector.z, c + (1 - c) * vector.y * vector.y, (1 - c) * vector.y * vector.z + s * vector.x, 0.0f),
-        float4((1 - c) * vector.x * vector.z + s * vector.y, (1 - c) * vector.y * vector.z + s * vector.x, c + (1 - c) * vector.z * vector.z, 0.0f),
+        float4((1 - c) * vector.x * vector.z + s * vector.y, (1 - c) * vector.y * vector.z - s * vector.x, c + (1 - c) * vector.z * vector.z, 0.0f),
         float4(0.0f, 0.0f, 0.0f, 1.0f)
     );
 }
 
-NEO_FUNC_DEF float4x4 float4x4::rotation_x(float angle) {
-    float c = std::cos(angle);
-    float s = std::sin(angle);
-
+NEO_FUNC_DEF float4x4 rotation_x(float c, float s) {
     return float4x4(
         float4(1.0f, 0.0f, 0.0f, 0.0f),
         float4(0.0f, c, -s, 0.0f),
@@ -47,10 +43,7 @@ NEO_FUNC_DEF float4x4 float4x4::rotation_x(float angle) {
     );
 }
 
-NEO_FUNC_DEF float4x4 float4x4::rotation_y(float angle) {
-    float c = std::cos(angle);
-    float s = std::sin(angle);
-
+NEO_FUNC_DEF float4x4 rotation_y(float c, float s) {
     return float4x4(
         float4(c, 0.0f, s, 0.0f),
         float4(0.0f, 1.0f, 0.0f, 0.0f),
@@ -59,10 +52,7 @@ NEO_FUNC_DEF float4x4 float4x4::rotation_y(float angle) {
     );
 }
 
-NEO_FUNC_DEF float4x4 float4x4::rotation_z(float angle) {
-    float c = std::cos(angle);
-    float s = std::sin(angle);
-
+NEO_FUNC_DEF float4x4 rotation_z(float c, float s) {
     return float4x4(
         float4(c, -s, 0.0f, 0.0f),
         float4(s, c, 0.0f, 0.0f),
@@ -71,6 +61,35 @@ NEO_FUNC_DEF float4x4 float4x4::rotation_z(float angle) {
     );
 }
 
+}
+
+NEO_FUNC_DEF float4x4 float4x4::rotation(const float3& vector, float angle) {
+    return detail::rotation(vector, std::cos(angle), std::sin(angle));
+}
+
+NEO_FUNC_DEF float4x4 float4x4::rotation(const float4& quaternion) {
+    float x = quaternion.x, y = quaternion.y, z = quaternion.z, w = quaternion.w;
+
+    return float4x4(
+        float4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f),
+        float4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f),
+        float4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f),
+        float4(0.0f, 0.0f, 0.0f, 1.0f)
+    );
+}
+
+NEO_FUNC_DEF float4x4 float4x4::rotation_x(float angle) {
+    return detail::rotation_x(std::cos(angle), std::sin(angle));
+}
+
+NEO_FUNC_DEF float4x4 float4x4::rotation_y(float angle) {
+    return detail::rotation_y(std::cos(angle), std::sin(angle));
+}
+
+NEO_FUNC_DEF float4x4 float4x4::rotation_z(float angle) {
+    return detail::rotation_z(std::cos(angle), std::sin(angle));
+}
+
 NEO_FUNC_DEF float4x4 float4x4::look_at(const float3& origin, const float3& target, const float3& up) {
     float3 z_axis = (origin - target).normalize();
     float3 x_axis = cross(up, z_axis).normalize();
@@ -84,6 +103,130 @@ NEO_FUNC_DEF float4x4 float4x4::look_at(const float3& origin, const float3& targ
     );
 }
 
+NEO_FUNC_DEF float4x4 float4x4::perspective(float fov_y, float aspect, float z_near, float z_far) {
+    float y_scale = 1.0f / std::tan(fov_y * 0.5f);
+    float x_scale = y_scale / aspect;
+    float z_range = 1.0f / (z_near - z_far);
+
+    return float4x4(
+        float4(x_scale, 0.0f, 0.0f, 0.0f),
+        float4(0.0f, y_scale, 0.0f, 0.0f),
+        float4(0.0f, 0.0f, z_far * z_range, -1.0f),
+        float4(0.0f, 0.0f, z_near * z_far * z_range, 0.0f)
+    );
+}
+
+NEO_FUNC_DEF float4x4 float4x4::perspective_reverse_z(float fov_y, float aspect, float z_near, float z_far) {
+    float y_scale = 1.0f / std::tan(fov_y * 0.5f);
+    float x_scale = y_scale / aspect;
+    float z_range = 1.0f / (z_far - z_near);
+
+    return float4x4(
+        float4(x_scale, 0.0f, 0.0f, 0.0f),
+        float4(0.0f, y_scale, 0.0f, 0.0f),
+        float4(0.0f, 0.0f, z_near * z_range, -1.0f),
+        float4(0.0f, 0.0f, z_near * z_far * z_range, 0.0f)
+    );
+}
+
+NEO_FUNC_DEF float4x4 float4x4::perspective_infinite(float fov_y, float aspect, float z_near) {
+    float y_scale = 1.0f / std::tan(fov_y * 0.5f);
+    float x_scale = y_scale / aspect;
+
+    return float4x4(
+        float4(x_scale, 0.0f, 0.0f, 0.0f),
+        float4(0.0f, y_scale, 0.0f, 0.0f),
+        float4(0.0f, 0.0f, -1.0f, -1.0f),
+        float4(0.0f, 0.0f, -z_near, 0.0f)
+    );
+}
+
+NEO_FUNC_DEF float4x4 float4x4::perspective_infinite_reverse_z(float fov_y, float aspect, float z_near) {
+    float y_scale = 1.0f / std::tan(fov_y * 0.5f);
+    float x_scale = y_scale / aspect;
+
+    return float4x4(
+        float4(x_scale, 0.0f, 0.0f, 0.0f),
+        float4(0.0f, y_scale, 0.0f, 0.0f),
+        float4(0.0f, 0.0f, 0.0f, -1.0f),
+        float4(0.0f, 0.0f, z_near, 0.0f)
+    );
+}
+
+NEO_FUNC_DEF float4x4 float4x4::orthographic(float left, float right, float bottom, float top, float z_near, float z_far) {
+    float x_range = 1.0f / (right - left);
+    float y_range = 1.0f / (top - bottom);
+    float z_range = 1.0f / (z_near - z_far);
+
+    return float4x4(
+        float4(2.0f * x_range, 0.0f, 0.0f, 0.0f),
+        float4(0.0f, 2.0f * y_range, 0.0f, 0.0f),
+        float4(0.0f, 0.0f, z_range, 0.0f),
+        float4(-(right + left) * x_range, -(top + bottom) * y_range, z_near * z_range, 1.0f)
+    );
+}
+
+NEO_FUNC_DEF float4x4 float4x4::orthographic_reverse_z(float left, float right, float bottom, float top, float z_near, float z_far) {
+    float x_range = 1.0f / (right - left);
+    float y_range = 1.0f / (top - bottom);
+    float z_range = 1.0f / (z_far - z_near);
+
+    return float4x4(
+        float4(2.0f * x_range, 0.0f, 0.0f, 0.0f),
+        float4(0.0f, 2.0f * y_range, 0.0f, 0.0f),
+        float4(0.0f, 0.0f, z_range, 0.0f),
+        float4(-(right + left) * x_range, -(top + bottom) * y_range, z_far * z_range, 1.0f)
+    );
+}
+
+NEO_BATCH_FUNC_DEF void float4x4::rotation(const float3* vectors, const float* angles, float4x4* matrices, size_t count) {
+    const size_t block = 256;
+    float sines[block], cosines[block];
+    for (size_t begin = 0; begin < count; begin += block) {
+        size_t size = count - begin < block ? count - begin : block;
+        sincos(angles + begin, sines, cosines, size);
+        for (size_t i = 0; i < size; i++) {
+            matrices[begin + i] = detail::rotation(vectors[begin + i], cosines[i], sines[i]);
+        }
+    }
+}
+
+NEO_BATCH_FUNC_DEF void float4x4::rotation_x(const float* angles, float4x4* matrices, size_t count) {
+    const size_t block = 256;
+    float sines[block], cosines[block];
+    for (size_t begin = 0; begin < count; begin += block) {
+        size_t size = count - begin < block ? count - begin : block;
+        sincos(angles + begin, sines, cosines, size);
+        for (size_t i = 0; i < size; i++) {
+            matrices[begin + i] = detail::rotation_x(cosines[i], sines[i]);
+        }
+    }
+}
+
+NEO_BATCH_FUNC_DEF void float4x4::rotation_y(const float* angles, float4x4* matrices, size_t count) {
+    const size_t block = 256;
+    float sines[block], cosines[block];
+    for (size_t begin = 0; begin < count; begin += block) {
+        size_t size = count - begin < block ? count - begin : block;
+        sincos(angles + begin, sines, cosines, size);
+        for (size_t i = 0; i < size; i++) {
+            matrices[begin + i] = detail::rotation_y(cosines[i], sines[i]);
+        }
+    }
+}
+
+NEO_BATCH_FUNC_DEF void float4x4::rotation_z(const float* angles, float4x4* matrices, size_t count) {
+    const size_t block = 256;
+    float sines[block], cosines[block];
+    for (size_t begin = 0; begin < count; begin += block) {
+        size_t size = count - begin < block ? count - begin : block;
+        sincos(angles + begin, sines, cosines, size);
+        for (size_t i = 0; i < size; i++) {
+            matrices[begin + i] = detail::rotation_z(cosines[i], sines[i]);
+        }
+    }
+}
+
 NEO_FUNC_DEF float2x2 float4x4::as_float2x2() const {
     return float2x2(c0.as_float2(), c1.as_float2());
 }
@@ -129,6 +272,38 @@ NEO_FUNC_DEF float4x4 float4x4::inverse() const {
     return inv / det;
 }
 
+// Cofactor matrix of the upper 3x3: scale-invariant up to length, so transformed normals only
+// need renormalizing.
+NEO_FUNC_DEF float3x3 float4x4::normal_matrix() const {
+    return as_float3x3().cofactor();
+}
+
+NEO_FUNC_DEF float4x4 float4x4::perspective_inverse() const {
+    float inv_x_scale = 1.0f / c0.x;
+    float inv_y_scale = 1.0f / c1.y;
+    float inv_z_offset = 1.0f / c3.z;
+
+    return float4x4(
+        float4(inv_x_scale, 0.0f, 0.0f, 0.0f),
+        float4(0.0f, inv_y_scale, 0.0f, 0.0f),
+        float4(0.0f, 0.0f, 0.0f, inv_z_offset),
+        float4(c2.x * inv_x_scale, c2.y * inv_y_scale, -1.0f, c2.z * inv_z_offset)
+    );
+}
+
+NEO_FUNC_DEF float4x4 float4x4::orthographic_inverse() const {
+    float inv_x_scale = 1.0f / c0.x;
+    float inv_y_scale = 1.0f / c1.y;
+    float inv_z_scale = 1.0f / c2.z;
+
+    return float4x4(
+        float4(inv_x_scale, 0.0f, 0.0f, 0.0f),
+        float4(0.0f, inv_y_scale, 0.0f, 0.0f),
+        float4(0.0f, 0.0f, inv_z_scale, 0.0f),
+        float4(-c3.x * inv_x_scale, -c3.y * inv_y_scale, -c3.z * inv_z_scale, 1.0f)
+    );
+}
+
 NEO_FUNC_DEF float float4x4::det() const {
     return c0.x * (c1.y * (c2.z * c3.w - c2.w * c3.z) - c1.z * (c2.y * c3.w - c2.w * c3.y) + c1.w * (c2.y * c3.z - c2.z * c3.y))
         - c0.y * (c1.x * (c2.z * c3.w - c2.w * c3.z) - c1.z * (c2.x * c3.w - c2.w * c3.x) + c1.w * (c2.x * c3.z - c2.z * c3.x))
@@ -238,6 +413,40 @@ NEO_FUNC_DEF const float4& float4x4::operator[](int index) const {
     return columns[index];
 }
 
+namespace detail {
+
+struct normal_matrix_kernel {
+    template <class V>
+    static void run(const float4x4* matrices, float3x3* normal_matrices, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V m[16], n[9];
+            simd::load_interleaved(&matrices[i].c0.x, m, 16, lanes);
+            const V* a = m;
+            const V* b = m + 4;
+            const V* c = m + 8;
+            n[0] = fnmadd(b[2], c[1], b[1] * c[2]);
+            n[1] = fnmadd(b[0], c[2], b[2] * c[0]);
+            n[2] = fnmadd(b[1], c[0], b[0] * c[1]);
+            n[3] = fnmadd(c[2], a[1], c[1] * a[2]);
+            n[4] = fnmadd(c[0], a[2], c[2] * a[0]);
+            n[5] = fnmadd(c[1], a[0], c[0] * a[1]);
+            n[6] = fnmadd(a[2], b[1], a[1] * b[2]);
+            n[7] = fnmadd(a[0], b[2], a[2] * b[0]);
+            n[8] = fnmadd(a[1], b[0], a[0] * b[1]);
+            simd::store_interleaved(n, &normal_matrices[i].c0.x, 9, lanes);
+        }
+    }
+};
+
+}
+
+NEO_BATCH_FUNC_DEF void normal_matrix(const float4x4* matrices, float3x3* normal_matrices, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::normal_matrix_kernel>(matrices, normal_matrices, begin, end);
+    });
+}
+
 }
 
 #endif
@@ -48,6 +48,146 @@ NEO_FUNC_DEF float4x4 lerp(const float4x4& lhs, const float4x4& rhs, float t) {
     return float4x4(lerp(lhs.c0, rhs.c0, t), lerp(lhs.c1, rhs.c1, t), lerp(lhs.c2, rhs.c2, t), lerp(lhs.c3, rhs.c3, t));
 }
 
+NEO_FUNC_DEF float2 min(const float2& lhs, const float2& rhs) {
+    return float2(simd::min(lhs.x, rhs.x), simd::min(lhs.y, rhs.y));
+}
+
+NEO_FUNC_DEF float3 min(const float3& lhs, const float3& rhs) {
+    return float3(simd::min(lhs.x, rhs.x), simd::min(lhs.y, rhs.y), simd::min(lhs.z, rhs.z));
+}
+
+NEO_FUNC_DEF float4 min(const float4& lhs, const float4& rhs) {
+    return float4(simd::min(lhs.x, rhs.x), simd::min(lhs.y, rhs.y), simd::min(lhs.z, rhs.z), simd::min(lhs.w, rhs.w));
+}
+
+NEO_FUNC_DEF float2 max(const float2& lhs, const float2& rhs) {
+    return float2(simd::max(lhs.x, rhs.x), simd::max(lhs.y, rhs.y));
+}
+
+NEO_FUNC_DEF float3 max(const float3& lhs, const float3& rhs) {
+    return float3(simd::max(lhs.x, rhs.x), simd::max(lhs.y, rhs.y), simd::max(lhs.z, rhs.z));
+}
+
+NEO_FUNC_DEF float4 max(const float4& lhs, const float4& rhs) {
+    return float4(simd::max(lhs.x, rhs.x), simd::max(lhs.y, rhs.y), simd::max(lhs.z, rhs.z), simd::max(lhs.w, rhs.w));
+}
+
+NEO_FUNC_DEF float2 abs(const float2& vector) {
+    return float2(fabsf(vector.x), fabsf(vector.y));
+}
+
+NEO_FUNC_DEF float3 abs(const float3& vector) {
+    return float3(fabsf(vector.x), fabsf(vector.y), fabsf(vector.z));
+}
+
+NEO_FUNC_DEF float4 abs(const float4& vector) {
+    return float4(fabsf(vector.x), fabsf(vector.y), fabsf(vector.z), fabsf(vector.w));
+}
+
+NEO_FUNC_DEF float2 clamp(const float2& vector, const float2& lower, const float2& upper) {
+    return min(max(vector, lower), upper);
+}
+
+NEO_FUNC_DEF float3 clamp(const float3& vector, const float3& lower, const float3& upper) {
+    return min(max(vector, lower), upper);
+}
+
+NEO_FUNC_DEF float4 clamp(const float4& vector, const float4& lower, const float4& upper) {
+    return min(max(vector, lower), upper);
+}
+
+namespace detail {
+
+// World position as origin + depth_scale(d) * (base + x * x_axis + y * y_axis + d * z_axis),
+// folded from the sparse projection inverse and the inverse view matrix once per call.
+struct unprojection {
+
+    float3 origin, base, x_axis, y_axis, z_axis;
+    float numerator, offset, slope;
+
+    NEO_FUNC_DECL unprojection(const float4x4& projection, const float4x4& view) {
+        float4x4 inverse_view = view.inverse();
+        float3 right = inverse_view.c0.as_float3();
+        float3 up = inverse_view.c1.as_float3();
+        float3 forward = inverse_view.c2.as_float3();
+        origin = inverse_view.c3.as_float3();
+
+        x_axis = right / projection.c0.x;
+        y_axis = up / projection.c1.y;
+
+        if (projection.c2.w != 0.0f) {
+            base = x_axis * projection.c2.x + y_axis * projection.c2.y - forward;
+            z_axis = float3(0.0f);
+            numerator = projection.c3.z;
+            offset = projection.c2.z;
+            slope = 1.0f;
+        } else {
+            z_axis = forward / projection.c2.z;
+            base = -(x_axis * projection.c3.x + y_axis * projection.c3.y + z_axis * projection.c3.z);
+            numerator = 1.0f;
+            offset = 1.0f;
+            slope = 0.0f;
+        }
+    }
+
+    NEO_FUNC_DECL float3 operator()(float x, float y, float depth) const {
+        float scale = numerator / (offset + slope * depth);
+        return origin + (base + x_axis * x + y_axis * y + z_axis * depth) * scale;
+    }
+
+};
+
+}
+
+NEO_FUNC_DEF void unproject(const float4x4& projection, const float4x4& view, const float3* ndc, float3* positions, size_t count) {
+    detail::unprojection unprojection(projection, view);
+    for (size_t i = 0; i < count; i++) {
+        positions[i] = unprojection(ndc[i].x, ndc[i].y, ndc[i].z);
+    }
+}
+
+NEO_FUNC_DEF void unproject(const float4x4& projection, const float4x4& view, const float* depth, int width, int height, float3* positions) {
+    detail::unprojection unprojection(projection, view);
+    float x_step = 2.0f / width;
+    float y_step = -2.0f / height;
+    for (int row = 0; row < height; row++) {
+        float y = 1.0f + (row + 0.5f) * y_step;
+        for (int column = 0; column < width; column++) {
+            float x = -1.0f + (column + 0.5f) * x_step;
+            size_t index = (size_t)row * width + column;
+            positions[index] = unprojection(x, y, depth[index]);
+        }
+    }
+}
+
+namespace detail {
+
+struct sincos_kernel {
+    template <class V>
+    static void run(const float* angles, float* sines, float* cosines, size_t count) {
+        size_t i = 0;
+        for (; i + V::width <= count; i += V::width) {
+            V sine, cosine;
+            simd::sincos(V::load(angles + i), sine, cosine);
+            sine.store(sines + i);
+            cosine.store(cosines + i);
+        }
+        if (i < count) {
+            int remaining = (int)(count - i);
+            V sine, cosine;
+            simd::sincos(V::load(angles + i, remaining), sine, cosine);
+            sine.store(sines + i, remaining);
+            cosine.store(cosines + i, remaining);
+        }
+    }
+};
+
+}
+
+NEO_BATCH_FUNC_DEF void sincos(const float* angles, float* sines, float* cosines, size_t count) {
+    simd::dispatch<detail::sincos_kernel>(angles, sines, cosines, count);
+}
+
 }
 
 #endif
@@ -0,0 +1,326 @@
+#ifndef KD_TREE_HPP
+#define KD_TREE_HPP
+
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+
+// Balanced k-d tree over a point set. Nodes live in an implicit complete binary tree (children of
+// node i are 2i + 1 and 2i + 2) and every leaf holds a contiguous run of the reordered points,
+// stored as separate x, y and z arrays so leaves are scanned several points per instruction.
+// Query results refer to indices into the array the tree was built from.
+class kd_tree {
+
+public:
+
+    enum { LEAF_SIZE = 32 };
+
+    NEO_BATCH_FUNC_DECL kd_tree() { }
+    NEO_BATCH_FUNC_DECL kd_tree(const float3* points, size_t count) { build(points, count); }
+    NEO_BATCH_FUNC_DECL kd_tree(const float* x, const float* y, const float* z, size_t count) { build(x, y, z, count); }
+
+    NEO_BATCH_FUNC_DECL void build(const float3* points, size_t count);
+    NEO_BATCH_FUNC_DECL void build(const float* x, const float* y, const float* z, size_t count);
+
+    NEO_BATCH_FUNC_DECL size_t size() const { return indices.size(); }
+
+    // Writes up to k neighbors sorted by increasing squared distance and returns how many were found.
+    NEO_BATCH_FUNC_DECL size_t nearest(const float3& query, size_t k, uint32_t* neighbors, float* distances_squared) const;
+    // Appends the indices of all points within radius (in no particular order) and returns their number.
+    NEO_BATCH_FUNC_DECL size_t radius(const float3& query, float radius, std::vector<uint32_t>& neighbors) const;
+
+    // Results of query i start at i * k; missing neighbors are UINT32_MAX with infinite distance.
+    NEO_BATCH_FUNC_DECL void nearest(const float3* queries, size_t count, size_t k, uint32_t* neighbors, float* distances_squared) const;
+    // Neighbors of query i are neighbors[offsets[i]] up to neighbors[offsets[i + 1]].
+    NEO_BATCH_FUNC_DECL void radius(const float3* queries, size_t count, float radius, std::vector<uint32_t>& offsets, std::vector<uint32_t>& neighbors) const;
+
+private:
+
+    struct node {
+        float split;
+        uint32_t axis;
+    };
+
+    struct point {
+        float coordinates[3];
+        uint32_t index;
+    };
+
+    int depth;
+    std::vector<node> nodes;
+    std::vector<size_t> leaf_offsets;
+    std::vector<float> xs, ys, zs;
+    std::vector<uint32_t> indices;
+
+    NEO_BATCH_FUNC_DECL void build(std::vector<point>& points);
+
+    template <class Visit>
+    void traverse(const float3& query, float& bound, const Visit& visit) const;
+
+    // Dispatched leaf scans for queries begin to end. nearest_kernel pads missing neighbors when
+    // pad is set and returns the count found for the last query; radius_kernel appends the
+    // neighbors, records per-query counts in counts unless it is null, and returns their total.
+    struct nearest_kernel;
+    struct radius_kernel;
+
+};
+
+NEO_BATCH_FUNC_DEF void kd_tree::build(const float3* points, size_t count) {
+    std::vector<point> entries(count);
+    parallel_for(count, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            point entry = { { points[i].x, points[i].y, points[i].z }, (uint32_t)i };
+            entries[i] = entry;
+        }
+    });
+    build(entries);
+}
+
+NEO_BATCH_FUNC_DEF void kd_tree::build(const float* x, const float* y, const float* z, size_t count) {
+    std::vector<point> entries(count);
+    parallel_for(count, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            point entry = { { x[i], y[i], z[i] }, (uint32_t)i };
+            entries[i] = entry;
+        }
+    });
+    build(entries);
+}
+
+// Splits each node at the median of the widest axis of its cell, one level at a time so that all
+// nodes of a level are partitioned in parallel. Cells start from the point bounds and are narrowed
+// by the splits above them.
+NEO_BATCH_FUNC_DEF void kd_tree::build(std::vector<point>& points) {
+    size_t count = points.size();
+    depth = 0;
+    while ((count >> depth) > LEAF_SIZE) depth++;
+
+    nodes.assign(((size_t)1 << depth) - 1, node());
+    std::vector<size_t> begins(1, 0), ends(1, count);
+    std::vector<float3> lowers(1), uppers(1);
+    if (count > 0) {
+        float3 first(points[0].coordinates[0], points[0].coordinates[1], points[0].coordinates[2]);
+        std::pair<float3, float3> cell = parallel_reduce(count, 1 << 16, std::make_pair(first, first),
+            [&](size_t begin, size_t end) {
+                std::pair<float3, float3> result(first, first);
+                for (size_t i = begin; i < end; i++) {
+                    float3 coordinates(points[i].coordinates[0], points[i].coordinates[1], points[i].coordinates[2]);
+                    result.first = min(result.first, coordinates);
+                    result.second = max(result.second, coordinates);
+                }
+                return result;
+            },
+            [](const std::pair<float3, float3>& lhs, const std::pair<float3, float3>& rhs) {
+                return std::make_pair(min(lhs.first, rhs.first), max(lhs.second, rhs.second));
+            });
+        lowers[0] = cell.first;
+        uppers[0] = cell.second;
+    }
+
+    for (int level = 0; level < depth; level++) {
+        size_t width = (size_t)1 << level, first = width - 1;
+        std::vector<size_t> child_begins(2 * width), child_ends(2 * width);
+        std::vector<float3> child_lowers(2 * width), child_uppers(2 * width);
+
+        parallel_for(width, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                float3 extent = uppers[i] - lowers[i];
+                uint32_t axis = extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2) : (extent.y >= extent.z ? 1 : 2);
+
+                size_t middle = begins[i] + (ends[i] - begins[i]) / 2;
+                std::nth_element(points.begin() + begins[i], points.begin() + middle, points.begin() + ends[i],
+                    [axis](const point& lhs, const point& rhs) { return lhs.coordinates[axis] < rhs.coordinates[axis]; });
+
+                node split = { points[middle].coordinates[axis], axis };
+                nodes[first + i] = split;
+
+                child_begins[2 * i] = begins[i];
+                child_ends[2 * i] = middle;
+                child_begins[2 * i + 1] = middle;
+                child_ends[2 * i + 1] = ends[i];
+                child_lowers[2 * i] = child_lowers[2 * i + 1] = lowers[i];
+                child_uppers[2 * i] = child_uppers[2 * i + 1] = uppers[i];
+                child_uppers[2 * i][axis] = split.split;
+                child_lowers[2 * i + 1][axis] = split.split;
+            }
+        });
+
+        begins.swap(child_begins);
+        ends.swap(child_ends);
+        lowers.swap(child_lowers);
+        uppers.swap(child_uppers);
+    }
+
+    leaf_offsets = begins;
+    leaf_offsets.push_back(count);
+
+    xs.resize(count);
+    ys.resize(count);
+    zs.resize(count);
+    indices.resize(count);
+    parallel_for(count, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            xs[i] = points[i].coordinates[0];
+            ys[i] = points[i].coordinates[1];
+            zs[i] = points[i].coordinates[2];
+            indices[i] = points[i].index;
+        }
+    });
+}
+
+// Depth-first descent into the nearer child first. Far children are kept with a lower bound on their
+// squared distance and skipped once the visitor has tightened the bound below it.
+template <class Visit>
+inline void kd_tree::traverse(const float3& query, float& bound, const Visit& visit) const {
+    if (indices.empty()) return;
+
+    struct entry {
+        size_t node;
+        float distance;
+    };
+
+    size_t internal = nodes.size();
+    entry stack[64];
+    int top = 0;
+    entry root = { 0, 0.0f };
+    stack[top++] = root;
+
+    while (top > 0) {
+        entry current = stack[--top];
+        if (current.distance > bound) continue;
+
+        size_t index = current.node;
+        while (index < internal) {
+            const node& split = nodes[index];
+            float difference = query[split.axis] - split.split;
+            size_t near_child = 2 * index + (difference < 0.0f ? 1 : 2);
+            entry far_child = { 4 * index + 3 - near_child, simd::max(current.distance, difference * difference) };
+            stack[top++] = far_child;
+            index = near_child;
+        }
+
+        size_t leaf = index - internal;
+        visit(leaf_offsets[leaf], leaf_offsets[leaf + 1]);
+    }
+}
+
+struct kd_tree::nearest_kernel {
+    template <class V>
+    static size_t run(const kd_tree* tree, const float3* queries, size_t k, uint32_t* neighbors, float* distances_squared, bool pad, size_t begin, size_t end) {
+        size_t found = 0;
+        for (size_t q = begin; q < end; q++) {
+            uint32_t* query_neighbors = neighbors + (q - begin) * k;
+            float* query_distances = distances_squared + (q - begin) * k;
+            float bound = std::numeric_limits<float>::infinity();
+            found = 0;
+
+            V qx(queries[q].x), qy(queries[q].y), qz(queries[q].z);
+            tree->traverse(queries[q], bound, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i += V::width) {
+                    int lanes = last - i < (size_t)V::width ? (int)(last - i) : (int)V::width;
+                    V dx = V::load(&tree->xs[i], lanes) - qx;
+                    V dy = V::load(&tree->ys[i], lanes) - qy;
+                    V dz = V::load(&tree->zs[i], lanes) - qz;
+                    V distance = fmadd(dx, dx, fmadd(dy, dy, dz * dz));
+
+                    int hits = mask_bits(distance < V(bound)) & ((1 << lanes) - 1);
+                    if (hits == 0) continue;
+
+                    float distance_lanes[V::width];
+                    distance.store(distance_lanes);
+                    for (int l = 0; l < lanes; l++) {
+                        if (!(hits >> l & 1) || distance_lanes[l] >= bound) continue;
+
+                        size_t slot = found < k ? found++ : k - 1;
+                        while (slot > 0 && query_distances[slot - 1] > distance_lanes[l]) {
+                            query_distances[slot] = query_distances[slot - 1];
+                            query_neighbors[slot] = query_neighbors[slot - 1];
+                            slot--;
+                        }
+                        query_distances[slot] = distance_lanes[l];
+                        query_neighbors[slot] = tree->indices[i + l];
+                        if (found == k) bound = query_distances[k - 1];
+                    }
+                }
+            });
+
+            for (size_t j = found; pad && j < k; j++) {
+                query_neighbors[j] = std::numeric_limits<uint32_t>::max();
+                query_distances[j] = std::numeric_limits<float>::infinity();
+            }
+        }
+        return found;
+    }
+};
+
+struct kd_tree::radius_kernel {
+    template <class V>
+    static size_t run(const kd_tree* tree, const float3* queries, float radius, uint32_t* counts, std::vector<uint32_t>* neighbors, size_t begin, size_t end) {
+        size_t total = neighbors->size();
+        for (size_t q = begin; q < end; q++) {
+            size_t previous = neighbors->size();
+            float bound = radius * radius;
+
+            V qx(queries[q].x), qy(queries[q].y), qz(queries[q].z), limit(bound);
+            tree->traverse(queries[q], bound, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i += V::width) {
+                    int lanes = last - i < (size_t)V::width ? (int)(last - i) : (int)V::width;
+                    V dx = V::load(&tree->xs[i], lanes) - qx;
+                    V dy = V::load(&tree->ys[i], lanes) - qy;
+                    V dz = V::load(&tree->zs[i], lanes) - qz;
+
+                    int hits = mask_bits(fmadd(dx, dx, fmadd(dy, dy, dz * dz)) <= limit) & ((1 << lanes) - 1);
+                    for (int l = 0; hits != 0; l++, hits >>= 1) {
+                        if (hits & 1) neighbors->push_back(tree->indices[i + l]);
+                    }
+                }
+            });
+            if (counts != nullptr) counts[q - begin] = (uint32_t)(neighbors->size() - previous);
+        }
+        return neighbors->size() - total;
+    }
+};
+
+NEO_BATCH_FUNC_DEF size_t kd_tree::nearest(const float3& query, size_t k, uint32_t* neighbors, float* distances_squared) const {
+    if (k == 0) return 0;
+    return simd::dispatch<nearest_kernel>(this, &query, k, neighbors, distances_squared, false, (size_t)0, (size_t)1);
+}
+
+NEO_BATCH_FUNC_DEF size_t kd_tree::radius(const float3& query, float radius, std::vector<uint32_t>& neighbors) const {
+    return simd::dispatch<radius_kernel>(this, &query, radius, (uint32_t*)nullptr, &neighbors, (size_t)0, (size_t)1);
+}
+
+NEO_BATCH_FUNC_DEF void kd_tree::nearest(const float3* queries, size_t count, size_t k, uint32_t* neighbors, float* distances_squared) const {
+    if (k == 0) return;
+    parallel_for(count, 64, [&](size_t begin, size_t end) {
+        simd::dispatch<nearest_kernel>(this, queries, k, neighbors + begin * k, distances_squared + begin * k, true, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void kd_tree::radius(const float3* queries, size_t count, float radius, std::vector<uint32_t>& offsets, std::vector<uint32_t>& neighbors) const {
+    const size_t grain = 64;
+    size_t blocks = (count + grain - 1) / grain;
+    std::vector<std::vector<uint32_t> > block_neighbors(blocks);
+
+    offsets.assign(count + 1, 0);
+    parallel_for(count, grain, [&](size_t begin, size_t end) {
+        simd::dispatch<radius_kernel>(this, queries, radius, &offsets[begin + 1], &block_neighbors[begin / grain], begin, end);
+    });
+
+    for (size_t i = 0; i < count; i++) offsets[i + 1] += offsets[i];
+
+    neighbors.resize(offsets[count]);
+    parallel_for(blocks, 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) std::copy(block_neighbors[b].begin(), block_neighbors[b].end(), neighbors.begin() + offsets[b * grain]);
+    });
+}
+
+}
+
+#endif
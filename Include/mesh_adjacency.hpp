@@ -0,0 +1,276 @@
+#ifndef MESH_ADJACENCY_HPP
+#define MESH_ADJACENCY_HPP
+
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+template <class V>
+inline void cross(const V* a, const V* b, V* result) {
+    result[0] = fnmadd(a[2], b[1], a[1] * b[2]);
+    result[1] = fnmadd(a[0], b[2], a[2] * b[0]);
+    result[2] = fnmadd(a[1], b[0], a[0] * b[1]);
+}
+
+template <class V>
+inline V dot(const V* a, const V* b) {
+    return fmadd(a[0], b[0], fmadd(a[1], b[1], a[2] * b[2]));
+}
+
+// Gathers the three corners of triangles i to i + lanes into registers, one per component.
+template <class V, class T>
+inline void gather_corners(const T* attributes, const uint32_t* indices, size_t i, int lanes, V (*corners)[sizeof(T) / sizeof(float)]) {
+    const int COMPONENTS = sizeof(T) / sizeof(float);
+    float gathered[3][COMPONENTS][V::width] = { };
+    for (int l = 0; l < lanes; l++) {
+        for (int k = 0; k < 3; k++) {
+            const float* attribute = (const float*)&attributes[indices[3 * (i + l) + k]];
+            for (int c = 0; c < COMPONENTS; c++) gathered[k][c][l] = attribute[c];
+        }
+    }
+    for (int k = 0; k < 3; k++) {
+        for (int c = 0; c < COMPONENTS; c++) corners[k][c] = V::load(gathered[k][c]);
+    }
+}
+
+// Face vector per triangle and weight per corner. Area weighting keeps the unnormalized cross
+// product (twice the area) with unit weights; angle weighting stores the unit normal and the
+// interior angle at each corner, zero where an adjacent edge has no length.
+struct face_normals_kernel {
+    template <class V>
+    static void run(const float3* positions, const uint32_t* indices, bool angle_weighted, float3* faces, float* weights, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V p[3][3], edges[3][3], normal[3];
+            gather_corners(positions, indices, i, lanes, p);
+            for (int c = 0; c < 3; c++) {
+                edges[0][c] = p[1][c] - p[0][c];
+                edges[1][c] = p[2][c] - p[1][c];
+                edges[2][c] = p[0][c] - p[2][c];
+            }
+            cross(edges[0], edges[1], normal);
+
+            if (!angle_weighted) {
+                simd::store_interleaved(normal, &faces[i].x, 3, lanes);
+                continue;
+            }
+
+            V length_squared = dot(normal, normal);
+            V inverse_length = select(length_squared > V(0.0f), rsqrt(length_squared), V(0.0f));
+            for (int c = 0; c < 3; c++) normal[c] = normal[c] * inverse_length;
+            simd::store_interleaved(normal, &faces[i].x, 3, lanes);
+
+            V edge_lengths[3], cosines[3];
+            for (int k = 0; k < 3; k++) edge_lengths[k] = dot(edges[k], edges[k]);
+            for (int k = 0; k < 3; k++) {
+                const V* incoming = edges[(k + 2) % 3];
+                const V* outgoing = edges[k];
+                V product = edge_lengths[k] * edge_lengths[(k + 2) % 3];
+                V cosine = min(max(V(0.0f) - dot(incoming, outgoing) * rsqrt(product), V(-1.0f)), V(1.0f));
+                cosines[k] = select(product > V(0.0f), cosine, V(1.0f));
+            }
+            float angles[3][V::width];
+            for (int k = 0; k < 3; k++) cosines[k].store(angles[k]);
+            for (int l = 0; l < lanes; l++) {
+                for (int k = 0; k < 3; k++) weights[3 * (i + l) + k] = std::acos(angles[k][l]);
+            }
+        }
+    }
+};
+
+// Texture-space tangent and bitangent per triangle: the derivatives of position along u and v, left
+// unnormalized. Their lengths grow with the ratio of the triangle's area to its texcoord area, which
+// is what weights the sums around a vertex. Triangles with degenerate texcoords contribute nothing.
+struct face_tangents_kernel {
+    template <class V>
+    static void run(const float3* positions, const float2* texcoords, const uint32_t* indices, float3* tangents, float3* bitangents, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V p[3][3], uv[3][2];
+            gather_corners(positions, indices, i, lanes, p);
+            gather_corners(texcoords, indices, i, lanes, uv);
+
+            V du1 = uv[1][0] - uv[0][0], dv1 = uv[1][1] - uv[0][1];
+            V du2 = uv[2][0] - uv[0][0], dv2 = uv[2][1] - uv[0][1];
+            V det = fnmadd(du2, dv1, du1 * dv2);
+            V r = select(abs(det) > V(1e-20f), V(1.0f) / det, V(0.0f));
+
+            V tangent[3], bitangent[3];
+            for (int c = 0; c < 3; c++) {
+                V e1 = p[1][c] - p[0][c], e2 = p[2][c] - p[0][c];
+                tangent[c] = fnmadd(e2, dv1, e1 * dv2) * r;
+                bitangent[c] = fnmadd(e1, du2, e2 * du1) * r;
+            }
+            simd::store_interleaved(tangent, &tangents[i].x, 3, lanes);
+            simd::store_interleaved(bitangent, &bitangents[i].x, 3, lanes);
+        }
+    }
+};
+
+struct normalize_kernel {
+    template <class V>
+    static void run(float3* vectors, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V v[3];
+            simd::load_interleaved(&vectors[i].x, v, 3, lanes);
+            V length_squared = dot(v, v);
+            V inverse_length = select(length_squared > V(0.0f), rsqrt(length_squared), V(0.0f));
+            for (int c = 0; c < 3; c++) v[c] = v[c] * inverse_length;
+            simd::store_interleaved(v, &vectors[i].x, 3, lanes);
+        }
+    }
+};
+
+// Gram-Schmidt against the normal; a tangent that vanishes is replaced by an arbitrary
+// perpendicular. w holds the handedness of the texture frame.
+struct orthogonalize_kernel {
+    template <class V>
+    static void run(const float3* normals, const float3* tangent_sums, const float3* bitangent_sums, float4* tangents, float3* bitangents, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V n[3], t[4], b[3];
+            simd::load_interleaved(&normals[i].x, n, 3, lanes);
+            simd::load_interleaved(&tangent_sums[i].x, t, 3, lanes);
+            simd::load_interleaved(&bitangent_sums[i].x, b, 3, lanes);
+
+            V projection = dot(n, t);
+            for (int c = 0; c < 3; c++) t[c] = fnmadd(n[c], projection, t[c]);
+            V length_squared = dot(t, t);
+
+            V x_axis = abs(n[0]) < V(0.9f);
+            V axis[3] = { select(x_axis, V(1.0f), V(0.0f)), select(x_axis, V(0.0f), V(1.0f)), V(0.0f) };
+            V fallback[3];
+            cross(axis, n, fallback);
+            V degenerate = length_squared <= V(1e-24f);
+            for (int c = 0; c < 3; c++) t[c] = select(degenerate, fallback[c], t[c]);
+            length_squared = dot(t, t);
+            V inverse_length = select(length_squared > V(0.0f), rsqrt(length_squared), V(0.0f));
+            for (int c = 0; c < 3; c++) t[c] = t[c] * inverse_length;
+
+            V frame[3];
+            cross(n, t, frame);
+            t[3] = select(dot(frame, b) < V(0.0f), V(-1.0f), V(1.0f));
+            simd::store_interleaved(t, &tangents[i].x, 4, lanes);
+
+            if (bitangents != nullptr) {
+                for (int c = 0; c < 3; c++) frame[c] = frame[c] * t[3];
+                simd::store_interleaved(frame, &bitangents[i].x, 3, lanes);
+            }
+        }
+    }
+};
+
+}
+
+// Triangles around every vertex of an indexed triangle list, stored as compressed rows of corners
+// (positions in the index list). Per-vertex attributes are computed by gathering over these rows,
+// so vertices can be processed in parallel without atomics and with a result that does not depend
+// on the thread count.
+class mesh_adjacency {
+
+public:
+
+    enum weighting { AREA_WEIGHTED, ANGLE_WEIGHTED };
+
+    NEO_BATCH_FUNC_DECL mesh_adjacency() { }
+    NEO_BATCH_FUNC_DECL mesh_adjacency(const uint32_t* indices, size_t index_count, size_t vertex_count) { build(indices, index_count, vertex_count); }
+
+    // Indices must be below vertex_count; a trailing partial triangle is ignored.
+    NEO_BATCH_FUNC_DECL void build(const uint32_t* indices, size_t index_count, size_t vertex_count);
+
+    NEO_BATCH_FUNC_DECL size_t vertex_count() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    NEO_BATCH_FUNC_DECL size_t triangle_count() const { return triangle_indices.size() / 3; }
+
+    // Corners referencing vertex in ascending order; corner / 3 is the triangle.
+    NEO_BATCH_FUNC_DECL const uint32_t* corners(size_t vertex) const { return vertex_corners.data() + offsets[vertex]; }
+    NEO_BATCH_FUNC_DECL size_t corner_count(size_t vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+
+    // Unit vertex normals; vertices without non-degenerate triangles get zero.
+    NEO_BATCH_FUNC_DECL void vertex_normals(const float3* positions, weighting weights, float3* normals) const;
+    // Unit tangents orthogonal to the given unit normals, with the bitangent sign in w so that
+    // bitangent = cross(normal, tangent.xyz) * tangent.w. bitangents may be null.
+    NEO_BATCH_FUNC_DECL void vertex_tangents(const float3* positions, const float2* texcoords, const float3* normals, float4* tangents, float3* bitangents = nullptr) const;
+
+private:
+
+    std::vector<uint32_t> triangle_indices;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> vertex_corners;
+
+};
+
+NEO_BATCH_FUNC_DEF void mesh_adjacency::build(const uint32_t* indices, size_t index_count, size_t vertex_count) {
+    triangle_indices.assign(indices, indices + index_count / 3 * 3);
+    offsets.assign(vertex_count + 1, 0);
+    for (size_t c = 0; c < triangle_indices.size(); c++) offsets[triangle_indices[c] + 1]++;
+    for (size_t v = 0; v < vertex_count; v++) offsets[v + 1] += offsets[v];
+
+    vertex_corners.resize(triangle_indices.size());
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    for (size_t c = 0; c < triangle_indices.size(); c++) vertex_corners[cursors[triangle_indices[c]]++] = (uint32_t)c;
+}
+
+NEO_BATCH_FUNC_DEF void mesh_adjacency::vertex_normals(const float3* positions, weighting weights, float3* normals) const {
+    size_t triangles = triangle_count();
+    bool angle_weighted = weights == ANGLE_WEIGHTED;
+    std::vector<float3> faces(triangles);
+    std::vector<float> corner_weights(angle_weighted ? 3 * triangles : 0);
+    const uint32_t* indices = triangle_indices.data();
+    float3* face_data = faces.data();
+    float* weight_data = corner_weights.data();
+    parallel_for(triangles, 1 << 12, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::face_normals_kernel>(positions, indices, angle_weighted, face_data, weight_data, begin, end);
+    });
+
+    parallel_for(vertex_count(), 1 << 12, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            float3 sum(0.0f);
+            for (uint32_t k = offsets[v]; k < offsets[v + 1]; k++) {
+                uint32_t corner = vertex_corners[k];
+                sum += angle_weighted ? faces[corner / 3] * corner_weights[corner] : faces[corner / 3];
+            }
+            normals[v] = sum;
+        }
+        simd::dispatch<detail::normalize_kernel>(normals, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void mesh_adjacency::vertex_tangents(const float3* positions, const float2* texcoords, const float3* normals, float4* tangents, float3* bitangents) const {
+    size_t triangles = triangle_count();
+    std::vector<float3> face_tangents(triangles), face_bitangents(triangles);
+    const uint32_t* indices = triangle_indices.data();
+    float3* tangent_data = face_tangents.data();
+    float3* bitangent_data = face_bitangents.data();
+    parallel_for(triangles, 1 << 12, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::face_tangents_kernel>(positions, texcoords, indices, tangent_data, bitangent_data, begin, end);
+    });
+
+    parallel_for(vertex_count(), 1 << 12, [&](size_t begin, size_t end) {
+        const size_t block = 256;
+        float3 tangent_sums[block], bitangent_sums[block];
+        for (size_t first = begin; first < end; first += block) {
+            size_t size = end - first < block ? end - first : block;
+            for (size_t j = 0; j < size; j++) {
+                float3 tangent(0.0f), bitangent(0.0f);
+                for (uint32_t k = offsets[first + j]; k < offsets[first + j + 1]; k++) {
+                    uint32_t triangle = vertex_corners[k] / 3;
+                    tangent += face_tangents[triangle];
+                    bitangent += face_bitangents[triangle];
+                }
+                tangent_sums[j] = tangent;
+                bitangent_sums[j] = bitangent;
+            }
+            simd::dispatch<detail::orthogonalize_kernel>(normals + first, (const float3*)tangent_sums, (const float3*)bitangent_sums, tangents + first, bitangents ? bitangents + first : nullptr, (size_t)0, size);
+        }
+    });
+}
+
+}
+
+#endif
@@ -0,0 +1,800 @@
+#ifndef MESH_IO_HPP
+#define MESH_IO_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+
+// Geometry read from a mesh or point cloud file; attributes missing from the file stay empty.
+// Polygons are fan-triangulated into indices, three per triangle. PLY attributes share the
+// position index; OBJ corners carry their own texcoord and normal indices, parallel to indices,
+// with UINT32_MAX for corners that have none.
+struct mesh {
+
+    std::vector<float3> positions;
+    std::vector<float3> normals;
+    std::vector<float2> texcoords;
+    std::vector<float4> colors;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> texcoord_indices;
+    std::vector<uint32_t> normal_indices;
+
+    NEO_BATCH_FUNC_DECL void clear();
+
+};
+
+// Both loaders stream the file in fixed-size chunks and parse every chunk in parallel. They return
+// false when the file cannot be read or is malformed, leaving result cleared.
+NEO_BATCH_FUNC_DECL bool load_obj(const char* path, mesh& result);
+// ASCII and binary (either byte order) PLY.
+NEO_BATCH_FUNC_DECL bool load_ply(const char* path, mesh& result);
+
+NEO_BATCH_FUNC_DEF void mesh::clear() {
+    positions.clear();
+    normals.clear();
+    texcoords.clear();
+    colors.clear();
+    indices.clear();
+    texcoord_indices.clear();
+    normal_indices.clear();
+}
+
+namespace detail {
+
+const size_t MESH_CHUNK_SIZE = 1 << 24;
+
+NEO_BATCH_FUNC_DEF bool is_digit(char c) {
+    return (unsigned)(c - '0') < 10;
+}
+
+NEO_BATCH_FUNC_DEF const char* skip_blanks(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+// Up to 19 significant digits are gathered into an integer and scaled by an exact power of ten in
+// double precision, which is correctly rounded to double while the mantissa fits 53 bits and the
+// exponent is within 22; the conversion to float then rounds a second time, so halfway cases can
+// be one ulp off. Everything else (long mantissas, large exponents, nan, inf) goes through strtod.
+NEO_BATCH_FUNC_DEF bool parse_float(const char*& pointer, const char* end, float& value) {
+    static const double powers[23] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* p = skip_blanks(pointer, end);
+    const char* start = p;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) p++;
+
+    uint64_t mantissa = 0;
+    int exponent = 0, digits = 0;
+    bool any = false, truncated = false;
+    for (; p < end && is_digit(*p); p++) {
+        any = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            if (mantissa != 0) digits++;
+        } else {
+            exponent++;
+            truncated = truncated || *p != '0';
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && is_digit(*p); p++) {
+            any = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                if (mantissa != 0) digits++;
+                exponent--;
+            } else {
+                truncated = truncated || *p != '0';
+            }
+        }
+    }
+    if (any && p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negative_exponent = q < end && *q == '-';
+        if (q < end && (*q == '-' || *q == '+')) q++;
+        if (q < end && is_digit(*q)) {
+            int e = 0;
+            for (; q < end && is_digit(*q); q++) {
+                if (e < 10000) e = e * 10 + (*q - '0');
+            }
+            exponent += negative_exponent ? -e : e;
+            p = q;
+        }
+    }
+
+    if (any && !truncated && mantissa <= (uint64_t)1 << 53 && exponent >= -22 && exponent <= 22) {
+        double result = (double)mantissa;
+        result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+        value = (float)(negative ? -result : result);
+        pointer = p;
+        return true;
+    }
+
+    if (!any) {
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+    }
+    std::string token(start, p);
+    char* parsed = nullptr;
+    double result = std::strtod(token.c_str(), &parsed);
+    if (token.empty() || parsed != token.c_str() + token.size()) return false;
+    value = (float)result;
+    pointer = p;
+    return true;
+}
+
+NEO_BATCH_FUNC_DEF bool parse_int(const char*& pointer, const char* end, int64_t& value) {
+    const char* p = skip_blanks(pointer, end);
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) p++;
+    if (p >= end || !is_digit(*p)) return false;
+    int64_t result = 0;
+    for (; p < end && is_digit(*p); p++) {
+        int digit = *p - '0';
+        if (result > (INT64_MAX - digit) / 10) return false;
+        result = result * 10 + digit;
+    }
+    value = negative ? -result : result;
+    pointer = p;
+    return true;
+}
+
+NEO_BATCH_FUNC_DEF const char* line_end(const char* p, const char* end) {
+    const char* found = (const char*)std::memchr(p, '\n', end - p);
+    return found ? found : end;
+}
+
+// Splits [begin, end) into up to pieces ranges that end at line breaks, for parallel parsing.
+NEO_BATCH_FUNC_DEF std::vector<const char*> split_lines(const char* begin, const char* end, size_t pieces) {
+    std::vector<const char*> bounds(1, begin);
+    size_t step = (size_t)(end - begin) / pieces + 1;
+    const char* p = begin;
+    while ((size_t)(end - p) > step) {
+        p = line_end(p + step, end);
+        if (p < end) p++;
+        bounds.push_back(p);
+    }
+    if (bounds.back() != end) bounds.push_back(end);
+    return bounds;
+}
+
+class file_handle {
+
+public:
+
+    NEO_BATCH_FUNC_DECL file_handle(const char* path, const char* mode): file(std::fopen(path, mode)) { }
+    NEO_BATCH_FUNC_DECL ~file_handle() { if (file) std::fclose(file); }
+
+    NEO_BATCH_FUNC_DECL FILE* get() const { return file; }
+
+private:
+
+    FILE* file;
+
+    file_handle(const file_handle&);
+    file_handle& operator=(const file_handle&);
+
+};
+
+// Reads a text file in chunks of whole lines; the partial line at the end of a read is carried over
+// to the next chunk, and the buffer only grows for lines longer than itself.
+class line_reader {
+
+public:
+
+    NEO_BATCH_FUNC_DECL line_reader(FILE* file, size_t size): file(file), buffer(size), filled(0), used(0), finished(false) { }
+
+    NEO_BATCH_FUNC_DECL bool next(const char*& begin, const char*& end) {
+        size_t remainder = filled - used;
+        if (remainder > 0 && used > 0) std::memmove(&buffer[0], &buffer[used], remainder);
+        filled = remainder;
+        used = 0;
+        for (;;) {
+            if (!finished) {
+                size_t requested = buffer.size() - filled;
+                size_t read = std::fread(&buffer[filled], 1, requested, file);
+                filled += read;
+                finished = read < requested;
+            }
+            if (filled == 0) return false;
+
+            size_t last = filled;
+            if (!finished) {
+                while (last > 0 && buffer[last - 1] != '\n') last--;
+            }
+            if (last == 0) {
+                buffer.resize(buffer.size() * 2);
+                continue;
+            }
+            used = last;
+            begin = &buffer[0];
+            end = begin + last;
+            return true;
+        }
+    }
+
+private:
+
+    FILE* file;
+    std::vector<char> buffer;
+    size_t filled, used;
+    bool finished;
+
+};
+
+// Hands out consecutive byte ranges of a binary file, refilling a fixed buffer as it drains.
+class byte_reader {
+
+public:
+
+    NEO_BATCH_FUNC_DECL byte_reader(FILE* file, size_t size): file(file), buffer(size), filled(0), used(0) { }
+
+    // Returns the next bytes, valid until the following call, or nullptr past the end of the file.
+    NEO_BATCH_FUNC_DECL const unsigned char* take(size_t bytes) {
+        if (filled - used < bytes) {
+            size_t remainder = filled - used;
+            if (remainder > 0 && used > 0) std::memmove(&buffer[0], &buffer[used], remainder);
+            if (buffer.size() < bytes) buffer.resize(bytes);
+            filled = remainder + std::fread(&buffer[remainder], 1, buffer.size() - remainder, file);
+            used = 0;
+            if (filled < bytes) return nullptr;
+        }
+        const unsigned char* result = &buffer[used];
+        used += bytes;
+        return result;
+    }
+
+    NEO_BATCH_FUNC_DECL size_t capacity() const { return buffer.size(); }
+
+private:
+
+    FILE* file;
+    std::vector<unsigned char> buffer;
+    size_t filled, used;
+
+};
+
+// Corner indices of one attribute as written in the file: positive ones are made zero-based,
+// negative ones are resolved against the count parsed so far in the same piece and listed in
+// relative, so that the count of earlier pieces can be added when pieces are merged.
+struct obj_indices {
+
+    std::vector<int64_t> values;
+    std::vector<size_t> relative;
+
+    NEO_BATCH_FUNC_DECL void push(int64_t index, size_t local_count) {
+        if (index < 0) {
+            relative.push_back(values.size());
+            values.push_back((int64_t)local_count + index);
+        } else {
+            values.push_back(index - 1);
+        }
+    }
+
+    NEO_BATCH_FUNC_DECL void push_missing() {
+        values.push_back(-((int64_t)1 << 62));
+    }
+
+};
+
+struct obj_piece {
+
+    std::vector<float3> positions, normals;
+    std::vector<float2> texcoords;
+    obj_indices indices, texcoord_indices, normal_indices;
+    bool failed;
+
+    NEO_BATCH_FUNC_DECL obj_piece(): failed(false) { }
+
+};
+
+// Reads v, v/vt, v//vn or v/vt/vn; absent indices are returned as 0, which OBJ never uses.
+NEO_BATCH_FUNC_DEF bool parse_obj_corner(const char*& p, const char* end, int64_t corner[3]) {
+    if (!parse_int(p, end, corner[0])) return false;
+    corner[1] = corner[2] = 0;
+    if (p < end && *p == '/') {
+        p++;
+        if (p < end && *p != '/' && !parse_int(p, end, corner[1])) return false;
+        if (p < end && *p == '/') {
+            p++;
+            if (!parse_int(p, end, corner[2])) return false;
+        }
+    }
+    return corner[0] != 0;
+}
+
+NEO_BATCH_FUNC_DEF void parse_obj(const char* p, const char* end, obj_piece& piece) {
+    std::vector<int64_t> corners;
+    while (p < end && !piece.failed) {
+        const char* last = line_end(p, end);
+        const char* q = skip_blanks(p, last);
+        if (last - q >= 2 && q[0] == 'v' && (q[1] == ' ' || q[1] == '\t')) {
+            float3 position;
+            q += 2;
+            piece.failed = !parse_float(q, last, position.x) || !parse_float(q, last, position.y) || !parse_float(q, last, position.z);
+            piece.positions.push_back(position);
+        } else if (last - q >= 3 && q[0] == 'v' && q[1] == 'n' && (q[2] == ' ' || q[2] == '\t')) {
+            float3 normal;
+            q += 3;
+            piece.failed = !parse_float(q, last, normal.x) || !parse_float(q, last, normal.y) || !parse_float(q, last, normal.z);
+            piece.normals.push_back(normal);
+        } else if (last - q >= 3 && q[0] == 'v' && q[1] == 't' && (q[2] == ' ' || q[2] == '\t')) {
+            float2 texcoord(0.0f);
+            q += 3;
+            piece.failed = !parse_float(q, last, texcoord.x);
+            parse_float(q, last, texcoord.y);
+            piece.texcoords.push_back(texcoord);
+        } else if (last - q >= 2 && q[0] == 'f' && (q[1] == ' ' || q[1] == '\t')) {
+            q += 2;
+            corners.clear();
+            int64_t corner[3];
+            for (;;) {
+                q = skip_blanks(q, last);
+                if (q == last || *q == '\r' || *q == '#') break;
+                if (!parse_obj_corner(q, last, corner)) {
+                    piece.failed = true;
+                    break;
+                }
+                corners.insert(corners.end(), corner, corner + 3);
+            }
+            size_t count = corners.size() / 3;
+            piece.failed = piece.failed || count < 3;
+            for (size_t i = 2; i < count && !piece.failed; i++) {
+                size_t triangle[3] = { 0, i - 1, i };
+                for (int k = 0; k < 3; k++) {
+                    const int64_t* c = &corners[triangle[k] * 3];
+                    piece.indices.push(c[0], piece.positions.size());
+                    if (c[1] != 0) piece.texcoord_indices.push(c[1], piece.texcoords.size());
+                    else piece.texcoord_indices.push_missing();
+                    if (c[2] != 0) piece.normal_indices.push(c[2], piece.normals.size());
+                    else piece.normal_indices.push_missing();
+                }
+            }
+        }
+        p = last + 1;
+    }
+}
+
+NEO_BATCH_FUNC_DEF bool append_obj_indices(const obj_indices& source, size_t base, std::vector<uint32_t>& target) {
+    size_t first = target.size();
+    target.resize(first + source.values.size());
+    for (size_t i = 0; i < source.values.size(); i++) {
+        int64_t value = source.values[i];
+        if (value >= UINT32_MAX) return false;
+        target[first + i] = value < -((int64_t)1 << 61) ? UINT32_MAX : (uint32_t)value;
+    }
+    for (size_t i = 0; i < source.relative.size(); i++) {
+        int64_t value = source.values[source.relative[i]] + (int64_t)base;
+        if (value < 0 || value >= UINT32_MAX) return false;
+        target[first + source.relative[i]] = (uint32_t)value;
+    }
+    return true;
+}
+
+NEO_BATCH_FUNC_DEF bool indices_valid(const std::vector<uint32_t>& indices, size_t count, bool allow_missing) {
+    for (size_t i = 0; i < indices.size(); i++) {
+        if (indices[i] >= count && !(allow_missing && indices[i] == UINT32_MAX)) return false;
+    }
+    return true;
+}
+
+enum ply_type { PLY_NONE, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64 };
+
+NEO_BATCH_FUNC_DEF ply_type ply_type_from_name(const std::string& name) {
+    if (name == "char" || name == "int8") return PLY_INT8;
+    if (name == "uchar" || name == "uint8") return PLY_UINT8;
+    if (name == "short" || name == "int16") return PLY_INT16;
+    if (name == "ushort" || name == "uint16") return PLY_UINT16;
+    if (name == "int" || name == "int32") return PLY_INT32;
+    if (name == "uint" || name == "uint32") return PLY_UINT32;
+    if (name == "float" || name == "float32") return PLY_FLOAT32;
+    if (name == "double" || name == "float64") return PLY_FLOAT64;
+    return PLY_NONE;
+}
+
+NEO_BATCH_FUNC_DEF size_t ply_type_size(ply_type type) {
+    static const size_t sizes[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+    return sizes[type];
+}
+
+NEO_BATCH_FUNC_DEF double read_ply_value(const unsigned char* p, ply_type type, bool swap) {
+    unsigned char bytes[8];
+    size_t size = ply_type_size(type);
+    for (size_t i = 0; i < size; i++) bytes[i] = p[swap ? size - 1 - i : i];
+    switch (type) {
+    case PLY_INT8: { int8_t v; std::memcpy(&v, bytes, 1); return v; }
+    case PLY_UINT8: return bytes[0];
+    case PLY_INT16: { int16_t v; std::memcpy(&v, bytes, 2); return v; }
+    case PLY_UINT16: { uint16_t v; std::memcpy(&v, bytes, 2); return v; }
+    case PLY_INT32: { int32_t v; std::memcpy(&v, bytes, 4); return v; }
+    case PLY_UINT32: { uint32_t v; std::memcpy(&v, bytes, 4); return v; }
+    case PLY_FLOAT32: { float v; std::memcpy(&v, bytes, 4); return v; }
+    case PLY_FLOAT64: { double v; std::memcpy(&v, bytes, 8); return v; }
+    default: return 0.0;
+    }
+}
+
+// Vertex properties are routed to slots: 0-2 position, 3-5 normal, 6-7 texcoord, 8-11 color.
+struct ply_property {
+
+    std::string name;
+    ply_type type, count_type;
+    int slot;
+    float scale;
+
+};
+
+struct ply_element {
+
+    std::string name;
+    size_t count;
+    std::vector<ply_property> properties;
+
+};
+
+struct ply_header {
+
+    enum format { ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN };
+
+    format encoding;
+    std::vector<ply_element> elements;
+    bool slots[12];
+
+};
+
+NEO_BATCH_FUNC_DEF int ply_vertex_slot(const std::string& name) {
+    static const char* const names[][12] = {
+        { "x", "y", "z", "nx", "ny", "nz", "u", "v", "red", "green", "blue", "alpha" },
+        { "", "", "", "normal_x", "normal_y", "normal_z", "s", "t", "r", "g", "b", "a" },
+        { "", "", "", "", "", "", "texture_u", "texture_v", "diffuse_red", "diffuse_green", "diffuse_blue", "" },
+        { "", "", "", "", "", "", "texture_s", "texture_t", "", "", "", "" }
+    };
+    for (int row = 0; row < 4; row++) {
+        for (int slot = 0; slot < 12; slot++) {
+            if (name == names[row][slot]) return slot;
+        }
+    }
+    return -1;
+}
+
+NEO_BATCH_FUNC_DEF bool read_ply_header(FILE* file, ply_header& header) {
+    char line[1024];
+    if (!std::fgets(line, sizeof(line), file) || std::strncmp(line, "ply", 3) != 0) return false;
+
+    bool has_format = false;
+    for (int slot = 0; slot < 12; slot++) header.slots[slot] = false;
+    while (std::fgets(line, sizeof(line), file)) {
+        std::vector<std::string> words;
+        for (const char* p = line; *p;) {
+            while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+            const char* start = p;
+            while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+            if (p > start) words.push_back(std::string(start, p));
+        }
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info") continue;
+
+        if (words[0] == "end_header") {
+            return has_format;
+        } else if (words[0] == "format" && words.size() >= 2) {
+            if (words[1] == "ascii") header.encoding = ply_header::ASCII;
+            else if (words[1] == "binary_little_endian") header.encoding = ply_header::BINARY_LITTLE_ENDIAN;
+            else if (words[1] == "binary_big_endian") header.encoding = ply_header::BINARY_BIG_ENDIAN;
+            else return false;
+            has_format = true;
+        } else if (words[0] == "element" && words.size() >= 3) {
+            ply_element element;
+            element.name = words[1];
+            element.count = (size_t)std::strtoull(words[2].c_str(), nullptr, 10);
+            header.elements.push_back(element);
+        } else if (words[0] == "property" && !header.elements.empty()) {
+            ply_element& element = header.elements.back();
+            ply_property property;
+            bool list = words.size() >= 5 && words[1] == "list";
+            if (!list && words.size() < 3) return false;
+            property.name = words.back();
+            property.count_type = list ? ply_type_from_name(words[2]) : PLY_NONE;
+            property.type = ply_type_from_name(words[list ? 3 : 1]);
+            if (property.type == PLY_NONE || (list && property.count_type == PLY_NONE)) return false;
+            property.slot = element.name == "vertex" && !list ? ply_vertex_slot(property.name) : -1;
+            property.scale = property.slot >= 8 && property.type == PLY_UINT8 ? 1.0f / 255.0f : property.slot >= 8 && property.type == PLY_UINT16 ? 1.0f / 65535.0f : 1.0f;
+            if (property.slot >= 0) header.slots[property.slot] = true;
+            element.properties.push_back(property);
+        }
+    }
+    return false;
+}
+
+// Size of one row, or 0 when list properties make rows variable.
+NEO_BATCH_FUNC_DEF size_t ply_row_size(const ply_element& element) {
+    size_t size = 0;
+    for (size_t k = 0; k < element.properties.size(); k++) {
+        if (element.properties[k].count_type != PLY_NONE) return 0;
+        size += ply_type_size(element.properties[k].type);
+    }
+    return size;
+}
+
+NEO_BATCH_FUNC_DEF void prepare_ply_vertices(const ply_header& header, size_t count, mesh& result) {
+    result.positions.resize(count);
+    if (header.slots[3] || header.slots[4] || header.slots[5]) result.normals.resize(count);
+    if (header.slots[6] || header.slots[7]) result.texcoords.resize(count);
+    if (header.slots[8] || header.slots[9] || header.slots[10] || header.slots[11]) result.colors.resize(count);
+}
+
+NEO_BATCH_FUNC_DEF void store_ply_vertex(const float* values, size_t index, mesh& result) {
+    result.positions[index] = float3(values[0], values[1], values[2]);
+    if (!result.normals.empty()) result.normals[index] = float3(values[3], values[4], values[5]);
+    if (!result.texcoords.empty()) result.texcoords[index] = float2(values[6], values[7]);
+    if (!result.colors.empty()) result.colors[index] = float4(values[8], values[9], values[10], values[11]);
+}
+
+NEO_BATCH_FUNC_DEF void reset_ply_values(float* values) {
+    for (int slot = 0; slot < 11; slot++) values[slot] = 0.0f;
+    values[11] = 1.0f;
+}
+
+NEO_BATCH_FUNC_DEF bool is_ply_face_list(const ply_element& element, const ply_property& property) {
+    return element.name == "face" && property.count_type != PLY_NONE && (property.name == "vertex_indices" || property.name == "vertex_index");
+}
+
+NEO_BATCH_FUNC_DEF void append_fan(const std::vector<uint32_t>& polygon, std::vector<uint32_t>& indices) {
+    for (size_t i = 2; i < polygon.size(); i++) {
+        indices.push_back(polygon[0]);
+        indices.push_back(polygon[i - 1]);
+        indices.push_back(polygon[i]);
+    }
+}
+
+// Integer list entries are parsed exactly and have to be whole tokens within the range of the
+// declared type.
+NEO_BATCH_FUNC_DEF bool parse_ply_integer(const char*& p, const char* end, ply_type type, int64_t& value) {
+    static const int64_t lower[] = { 0, -128, 0, -32768, 0, -2147483648LL, 0 };
+    static const int64_t upper[] = { 0, 127, 255, 32767, 65535, 2147483647LL, 4294967295LL };
+    if (!parse_int(p, end, value)) return false;
+    if (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') return false;
+    return value >= lower[type] && value <= upper[type];
+}
+
+// Face indices have to be whole numbers in the range of uint32_t, whatever type the file stores.
+NEO_BATCH_FUNC_DEF bool ply_face_index(double value, uint32_t& index) {
+    if (!(value >= 0.0 && value < 4294967296.0)) return false;
+    index = (uint32_t)value;
+    return index == value;
+}
+
+// Parses the rows of one element from ASCII lines; returns false on malformed rows or face indices
+// that are negative or not integers.
+NEO_BATCH_FUNC_DEF bool parse_ply_ascii_row(const ply_element& element, const char* p, const char* end, float* values, std::vector<uint32_t>& polygon) {
+    polygon.clear();
+    for (size_t k = 0; k < element.properties.size(); k++) {
+        const ply_property& property = element.properties[k];
+        float value;
+        if (property.count_type != PLY_NONE) {
+            int64_t count;
+            if (!parse_int(p, end, count) || count < 0) return false;
+            bool face = is_ply_face_list(element, property);
+            for (int64_t i = 0; i < count; i++) {
+                if (property.type < PLY_FLOAT32) {
+                    int64_t index;
+                    if (!parse_ply_integer(p, end, property.type, index)) return false;
+                    if (!face) continue;
+                    if (index < 0) return false;
+                    polygon.push_back((uint32_t)index);
+                } else {
+                    uint32_t index;
+                    if (!parse_float(p, end, value)) return false;
+                    if (!face) continue;
+                    if (!ply_face_index(value, index)) return false;
+                    polygon.push_back(index);
+                }
+            }
+        } else {
+            if (!parse_float(p, end, value)) return false;
+            if (property.slot >= 0) values[property.slot] = value * property.scale;
+        }
+    }
+    return true;
+}
+
+NEO_BATCH_FUNC_DEF bool load_ply_ascii(FILE* file, const ply_header& header, mesh& result) {
+    line_reader reader(file, MESH_CHUNK_SIZE);
+    size_t element = 0, row = 0;
+    std::vector<const char*> lines;
+    const char* begin;
+    const char* end;
+    while (element < header.elements.size() && reader.next(begin, end)) {
+        lines.clear();
+        for (const char* p = begin; p < end;) {
+            const char* last = line_end(p, end);
+            const char* q = skip_blanks(p, last);
+            if (q < last && *q != '\r') lines.push_back(p);
+            p = last + 1;
+        }
+        lines.push_back(end);
+
+        size_t line = 0, line_count = lines.size() - 1;
+        while (line < line_count && element < header.elements.size()) {
+            const ply_element& current = header.elements[element];
+            size_t rows = current.count - row < line_count - line ? current.count - row : line_count - line;
+            bool vertex = current.name == "vertex", face = current.name == "face";
+
+            if (vertex || face) {
+                size_t pieces = vertex ? (rows + 4095) / 4096 : (size_t)thread_count() * 4;
+                if (pieces > rows) pieces = rows;
+                std::vector<std::vector<uint32_t> > triangles(pieces);
+                std::vector<char> failed(pieces, 0);
+                parallel_for(pieces, 1, [&](size_t piece_begin, size_t piece_end) {
+                    for (size_t piece = piece_begin; piece < piece_end; piece++) {
+                        std::vector<uint32_t> polygon;
+                        float values[12];
+                        for (size_t r = rows * piece / pieces; r < rows * (piece + 1) / pieces && !failed[piece]; r++) {
+                            const char* p = lines[line + r];
+                            const char* last = line_end(p, lines[line + r + 1]);
+                            reset_ply_values(values);
+                            if (!parse_ply_ascii_row(current, p, last, values, polygon)) failed[piece] = 1;
+                            else if (vertex) store_ply_vertex(values, row + r, result);
+                            else append_fan(polygon, triangles[piece]);
+                        }
+                    }
+                });
+                for (size_t piece = 0; piece < pieces; piece++) {
+                    if (failed[piece]) return false;
+                    result.indices.insert(result.indices.end(), triangles[piece].begin(), triangles[piece].end());
+                }
+            }
+
+            line += rows;
+            row += rows;
+            if (row == current.count) {
+                element++;
+                row = 0;
+            }
+        }
+    }
+    for (; element < header.elements.size() && header.elements[element].count == 0; element++) { }
+    return element == header.elements.size();
+}
+
+NEO_BATCH_FUNC_DEF bool load_ply_binary(FILE* file, const ply_header& header, mesh& result) {
+    uint16_t one = 1;
+    unsigned char first_byte;
+    std::memcpy(&first_byte, &one, 1);
+    bool swap = (first_byte == 1) != (header.encoding == ply_header::BINARY_LITTLE_ENDIAN);
+
+    byte_reader reader(file, MESH_CHUNK_SIZE);
+    std::vector<uint32_t> polygon;
+    for (size_t e = 0; e < header.elements.size(); e++) {
+        const ply_element& element = header.elements[e];
+        bool vertex = element.name == "vertex";
+
+        // Fixed-size vertex records are parsed in parallel a buffer at a time.
+        size_t stride = ply_row_size(element);
+        if (vertex && stride > 0) {
+            size_t batch = reader.capacity() / stride > 0 ? reader.capacity() / stride : 1;
+            for (size_t row = 0; row < element.count; row += batch) {
+                size_t rows = element.count - row < batch ? element.count - row : batch;
+                const unsigned char* records = reader.take(rows * stride);
+                if (!records) return false;
+                parallel_for(rows, 1 << 12, [&](size_t begin, size_t end) {
+                    float values[12];
+                    for (size_t r = begin; r < end; r++) {
+                        const unsigned char* p = records + r * stride;
+                        reset_ply_values(values);
+                        for (size_t k = 0; k < element.properties.size(); k++) {
+                            const ply_property& property = element.properties[k];
+                            if (property.slot >= 0) values[property.slot] = (float)read_ply_value(p, property.type, swap) * property.scale;
+                            p += ply_type_size(property.type);
+                        }
+                        store_ply_vertex(values, row + r, result);
+                    }
+                });
+            }
+            continue;
+        }
+
+        float values[12];
+        for (size_t row = 0; row < element.count; row++) {
+            reset_ply_values(values);
+            polygon.clear();
+            for (size_t k = 0; k < element.properties.size(); k++) {
+                const ply_property& property = element.properties[k];
+                size_t size = ply_type_size(property.type);
+                if (property.count_type != PLY_NONE) {
+                    const unsigned char* p = reader.take(ply_type_size(property.count_type));
+                    if (!p) return false;
+                    double count = read_ply_value(p, property.count_type, swap);
+                    if (!(count >= 0.0 && count < 4294967296.0) || count != (double)(uint32_t)count || (size_t)count > (size_t)-1 / size) return false;
+                    p = reader.take((size_t)count * size);
+                    if (!p) return false;
+                    if (is_ply_face_list(element, property)) {
+                        for (size_t i = 0; i < (size_t)count; i++) {
+                            uint32_t index;
+                            if (!ply_face_index(read_ply_value(p + i * size, property.type, swap), index)) return false;
+                            polygon.push_back(index);
+                        }
+                    }
+                } else {
+                    const unsigned char* p = reader.take(size);
+                    if (!p) return false;
+                    if (property.slot >= 0) values[property.slot] = (float)read_ply_value(p, property.type, swap) * property.scale;
+                }
+            }
+            if (vertex) store_ply_vertex(values, row, result);
+            else append_fan(polygon, result.indices);
+        }
+    }
+    return true;
+}
+
+}
+
+NEO_BATCH_FUNC_DEF bool load_obj(const char* path, mesh& result) {
+    result.clear();
+    detail::file_handle file(path, "rb");
+    if (!file.get()) return false;
+
+    detail::line_reader reader(file.get(), detail::MESH_CHUNK_SIZE);
+    const char* begin;
+    const char* end;
+    while (reader.next(begin, end)) {
+        std::vector<const char*> bounds = detail::split_lines(begin, end, (size_t)thread_count() * 4);
+        std::vector<detail::obj_piece> pieces(bounds.size() - 1);
+        parallel_for(pieces.size(), 1, [&](size_t piece_begin, size_t piece_end) {
+            for (size_t piece = piece_begin; piece < piece_end; piece++) detail::parse_obj(bounds[piece], bounds[piece + 1], pieces[piece]);
+        });
+
+        for (size_t i = 0; i < pieces.size(); i++) {
+            const detail::obj_piece& piece = pieces[i];
+            bool valid = !piece.failed &&
+                detail::append_obj_indices(piece.indices, result.positions.size(), result.indices) &&
+                detail::append_obj_indices(piece.texcoord_indices, result.texcoords.size(), result.texcoord_indices) &&
+                detail::append_obj_indices(piece.normal_indices, result.normals.size(), result.normal_indices);
+            if (!valid) {
+                result.clear();
+                return false;
+            }
+            result.positions.insert(result.positions.end(), piece.positions.begin(), piece.positions.end());
+            result.normals.insert(result.normals.end(), piece.normals.begin(), piece.normals.end());
+            result.texcoords.insert(result.texcoords.end(), piece.texcoords.begin(), piece.texcoords.end());
+        }
+    }
+
+    if (result.texcoords.empty()) result.texcoord_indices.clear();
+    if (result.normals.empty()) result.normal_indices.clear();
+    bool valid = detail::indices_valid(result.indices, result.positions.size(), false) &&
+        detail::indices_valid(result.texcoord_indices, result.texcoords.size(), true) &&
+        detail::indices_valid(result.normal_indices, result.normals.size(), true);
+    if (!valid) result.clear();
+    return valid;
+}
+
+NEO_BATCH_FUNC_DEF bool load_ply(const char* path, mesh& result) {
+    result.clear();
+    detail::file_handle file(path, "rb");
+    if (!file.get()) return false;
+
+    detail::ply_header header;
+    if (!detail::read_ply_header(file.get(), header)) return false;
+    for (size_t e = 0; e < header.elements.size(); e++) {
+        if (header.elements[e].name == "vertex") detail::prepare_ply_vertices(header, header.elements[e].count, result);
+    }
+
+    bool valid = header.encoding == detail::ply_header::ASCII ? detail::load_ply_ascii(file.get(), header, result) : detail::load_ply_binary(file.get(), header, result);
+    valid = valid && detail::indices_valid(result.indices, result.positions.size(), false);
+    if (!valid) result.clear();
+    return valid;
+}
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef MORTON_HPP
+#define MORTON_HPP
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+// Bit layout follows Karras: bit 3i + 2 of a code is bit i of x, 3i + 1 of y and 3i of z.
+NEO_FUNC_DEF uint32_t spread_bits_10(uint32_t x) {
+    x &= 0x000003FFu;
+    x = (x | x << 16) & 0x030000FFu;
+    x = (x | x << 8) & 0x0300F00Fu;
+    x = (x | x << 4) & 0x030C30C3u;
+    x = (x | x << 2) & 0x09249249u;
+    return x;
+}
+
+NEO_FUNC_DEF uint64_t spread_bits_21(uint64_t x) {
+    x &= 0x00000000001FFFFFull;
+    x = (x | x << 32) & 0x001F00000000FFFFull;
+    x = (x | x << 16) & 0x001F0000FF0000FFull;
+    x = (x | x << 8) & 0x100F00F00F00F00Full;
+    x = (x | x << 4) & 0x10C30C30C30C30C3ull;
+    x = (x | x << 2) & 0x1249249249249249ull;
+    return x;
+}
+
+NEO_FUNC_DEF uint32_t interleave_30(uint32_t x, uint32_t y, uint32_t z) {
+#if NEO_BMI2
+    return _pdep_u32(x, 0x24924924u) | _pdep_u32(y, 0x12492492u) | _pdep_u32(z, 0x09249249u);
+#else
+    return spread_bits_10(x) << 2 | spread_bits_10(y) << 1 | spread_bits_10(z);
+#endif
+}
+
+NEO_FUNC_DEF uint64_t interleave_63(uint32_t x, uint32_t y, uint32_t z) {
+#if NEO_BMI2 && (defined(__x86_64__) || defined(_M_X64))
+    return _pdep_u64(x, 0x4924924924924924ull) | _pdep_u64(y, 0x2492492492492492ull) | _pdep_u64(z, 0x1249249249249249ull);
+#else
+    return spread_bits_21(x) << 2 | spread_bits_21(y) << 1 | spread_bits_21(z);
+#endif
+}
+
+// Maps positions to integer grid coordinates in [0, resolution - 1], clamping outside the bounds.
+struct morton_quantizer {
+
+    float3 lower, scale;
+    float resolution;
+
+    NEO_FUNC_DECL morton_quantizer(const float3& lower, const float3& upper, float resolution): lower(lower), resolution(resolution) {
+        float3 extent = upper - lower;
+        scale = float3(
+            extent.x > 0.0f ? resolution / extent.x : 0.0f,
+            extent.y > 0.0f ? resolution / extent.y : 0.0f,
+            extent.z > 0.0f ? resolution / extent.z : 0.0f
+        );
+    }
+
+    NEO_FUNC_DECL uint32_t operator()(float position, int axis) const {
+        float cell = (position - lower[axis]) * scale[axis];
+        return (uint32_t)simd::min(simd::max(cell, 0.0f), resolution - 1.0f);
+    }
+
+};
+
+template <class V>
+inline typename V::int_type quantize(const V& position, float lower, float scale, float resolution) {
+    V cell = (position - V(lower)) * V(scale);
+    return to_int(min(max(cell, V(0.0f)), V(resolution - 1.0f)));
+}
+
+}
+
+NEO_FUNC_DEF uint32_t morton30(const float3& position, const float3& lower, const float3& upper) {
+    detail::morton_quantizer quantizer(lower, upper, 1024.0f);
+    return detail::interleave_30(quantizer(position.x, 0), quantizer(position.y, 1), quantizer(position.z, 2));
+}
+
+NEO_FUNC_DEF uint64_t morton63(const float3& position, const float3& lower, const float3& upper) {
+    detail::morton_quantizer quantizer(lower, upper, 2097152.0f);
+    return detail::interleave_63(quantizer(position.x, 0), quantizer(position.y, 1), quantizer(position.z, 2));
+}
+
+namespace detail {
+
+// Quantization and bit spreading run in SIMD lanes; bits are spread with shifts rather than pdep
+// because the 30 bit code fits a 32 bit lane.
+struct morton30_kernel {
+    template <class V>
+    static void run(const float3* positions, morton_quantizer quantizer, uint32_t* codes, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+
+        const float* first = &positions[0].x;
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            I code(0);
+            for (int axis = 0; axis < 3; axis++) {
+                V position = simd::load_strided<V>(first + 3 * i + axis, 3, lanes);
+                I x = quantize(position, quantizer.lower[axis], quantizer.scale[axis], quantizer.resolution);
+                x = (x | x << 16) & I(0x030000FF);
+                x = (x | x << 8) & I(0x0300F00F);
+                x = (x | x << 4) & I(0x030C30C3);
+                x = (x | x << 2) & I(0x09249249);
+                code = code | x << (2 - axis);
+            }
+            code.store(codes + i, lanes);
+        }
+    }
+};
+
+// Quantization runs in SIMD lanes; the 63 bit interleave uses pdep where BMI2 is available.
+struct morton63_kernel {
+    template <class V>
+    static void run(const float3* positions, morton_quantizer quantizer, uint64_t* codes, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+
+        const float* first = &positions[0].x;
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            uint32_t cells[3][V::width];
+            for (int axis = 0; axis < 3; axis++) {
+                V position = simd::load_strided<V>(first + 3 * i + axis, 3, lanes);
+                I cell = quantize(position, quantizer.lower[axis], quantizer.scale[axis], quantizer.resolution);
+                cell.store(cells[axis]);
+            }
+            for (int l = 0; l < lanes; l++) codes[i + l] = interleave_63(cells[0][l], cells[1][l], cells[2][l]);
+        }
+    }
+};
+
+}
+
+NEO_BATCH_FUNC_DEF void morton30(const float3* positions, const float3& lower, const float3& upper, uint32_t* codes, size_t count) {
+    detail::morton_quantizer quantizer(lower, upper, 1024.0f);
+    parallel_for(count, 1 << 16, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::morton30_kernel>(positions, quantizer, codes, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void morton63(const float3* positions, const float3& lower, const float3& upper, uint64_t* codes, size_t count) {
+    detail::morton_quantizer quantizer(lower, upper, 2097152.0f);
+    parallel_for(count, 1 << 16, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::morton63_kernel>(positions, quantizer, codes, begin, end);
+    });
+}
+
+}
+
+#endif
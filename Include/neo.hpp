@@ -2,6 +2,7 @@
 #define NEO_HPP
 
 #include <cmath>
+#include <cstddef>
 
 // CUDA support
 #ifdef __CUDACC__
@@ -15,6 +16,11 @@
 // Function qualifiers
 #define NEO_FUNC_DECL NEO_CUDA_FUNC_DECL
 #define NEO_FUNC_DEF inline NEO_CUDA_FUNC_DEF
+#define NEO_BATCH_FUNC_DECL
+#define NEO_BATCH_FUNC_DEF inline
+
+#include "simd.hpp"
+#include "parallel.hpp"
 
 namespace neo {
 
@@ -39,6 +45,10 @@ struct float2 {
     NEO_FUNC_DECL float3 as_float3(float z = 0.0f) const;
     NEO_FUNC_DECL float4 as_float4(float z = 0.0f, float w = 0.0f) const;
 
+    template <int X, int Y> NEO_FUNC_DECL float2 swizzle() const;
+    template <int X, int Y, int Z> NEO_FUNC_DECL float3 swizzle() const;
+    template <int X, int Y, int Z, int W> NEO_FUNC_DECL float4 swizzle() const;
+
     NEO_FUNC_DECL float length() const;
     NEO_FUNC_DECL float2 normalize() const;
     NEO_FUNC_DECL float2 proj(const float2& other) const;
@@ -84,6 +94,10 @@ struct float3 {
     NEO_FUNC_DECL float2 as_float2() const;
     NEO_FUNC_DECL float4 as_float4(float w = 0.0f) const;
 
+    template <int X, int Y> NEO_FUNC_DECL float2 swizzle() const;
+    template <int X, int Y, int Z> NEO_FUNC_DECL float3 swizzle() const;
+    template <int X, int Y, int Z, int W> NEO_FUNC_DECL float4 swizzle() const;
+
     NEO_FUNC_DECL float length() const;
     NEO_FUNC_DECL float3 normalize() const;
     NEO_FUNC_DECL float3 proj(const float3& other) const;
@@ -129,6 +143,10 @@ struct float4 {
     NEO_FUNC_DECL float2 as_float2() const;
     NEO_FUNC_DECL float3 as_float3() const;
 
+    template <int X, int Y> NEO_FUNC_DECL float2 swizzle() const;
+    template <int X, int Y, int Z> NEO_FUNC_DECL float3 swizzle() const;
+    template <int X, int Y, int Z, int W> NEO_FUNC_DECL float4 swizzle() const;
+
     NEO_FUNC_DECL float length() const;
     NEO_FUNC_DECL float4 normalize() const;
     NEO_FUNC_DECL float4 proj(const float4& other) const;
@@ -220,8 +238,13 @@ struct float3x3 {
 
     NEO_FUNC_DECL float3x3 transpose() const;
     NEO_FUNC_DECL float3x3 inverse() const;
+    NEO_FUNC_DECL float3x3 cofactor() const;
     NEO_FUNC_DECL float det() const;
 
+    NEO_FUNC_DECL void symmetric_eigen(float3& values, float3x3& vectors) const;
+    NEO_FUNC_DECL void svd(float3x3& u, float3& sigma, float3x3& v) const;
+    NEO_FUNC_DECL void polar(float3x3& rotation, float3x3& stretch) const;
+
     NEO_FUNC_DECL float3x3 operator-() const;
 
     NEO_FUNC_DECL float3x3 operator+(float scalar) const;
@@ -261,18 +284,36 @@ struct float4x4 {
     static NEO_FUNC_DECL float4x4 scale(const float3& vector);
     static NEO_FUNC_DECL float4x4 translation(const float3& vector);
     static NEO_FUNC_DECL float4x4 rotation(const float3& vector, float angle);
+    static NEO_FUNC_DECL float4x4 rotation(const float4& quaternion);
     static NEO_FUNC_DECL float4x4 rotation_x(float angle);
     static NEO_FUNC_DECL float4x4 rotation_y(float angle);
     static NEO_FUNC_DECL float4x4 rotation_z(float angle);
     static NEO_FUNC_DECL float4x4 look_at(const float3& origin, const float3& target, const float3& up);
+    static NEO_FUNC_DECL float4x4 perspective(float fov_y, float aspect, float z_near, float z_far);
+    static NEO_FUNC_DECL float4x4 perspective_reverse_z(float fov_y, float aspect, float z_near, float z_far);
+    static NEO_FUNC_DECL float4x4 perspective_infinite(float fov_y, float aspect, float z_near);
+    static NEO_FUNC_DECL float4x4 perspective_infinite_reverse_z(float fov_y, float aspect, float z_near);
+    static NEO_FUNC_DECL float4x4 orthographic(float left, float right, float bottom, float top, float z_near, float z_far);
+    static NEO_FUNC_DECL float4x4 orthographic_reverse_z(float left, float right, float bottom, float top, float z_near, float z_far);
+
+    static NEO_BATCH_FUNC_DECL void rotation(const float3* vectors, const float* angles, float4x4* matrices, size_t count);
+    static NEO_BATCH_FUNC_DECL void rotation_x(const float* angles, float4x4* matrices, size_t count);
+    static NEO_BATCH_FUNC_DECL void rotation_y(const float* angles, float4x4* matrices, size_t count);
+    static NEO_BATCH_FUNC_DECL void rotation_z(const float* angles, float4x4* matrices, size_t count);
 
     NEO_FUNC_DECL float2x2 as_float2x2() const;
     NEO_FUNC_DECL float3x3 as_float3x3() const;
 
     NEO_FUNC_DECL float4x4 transpose() const;
     NEO_FUNC_DECL float4x4 inverse() const;
+    NEO_FUNC_DECL float4x4 perspective_inverse() const;
+    NEO_FUNC_DECL float4x4 orthographic_inverse() const;
+    NEO_FUNC_DECL float3x3 normal_matrix() const;
     NEO_FUNC_DECL float det() const;
 
+    NEO_FUNC_DECL void decompose(float3& translation, float3x3& rotation, float3& scale) const;
+    NEO_FUNC_DECL void decompose(float3& translation, float4& rotation, float3& scale) const;
+
     NEO_FUNC_DECL float4x4 operator-() const;
 
     NEO_FUNC_DECL float4x4 operator+(float scalar) const;
@@ -313,6 +354,74 @@ NEO_FUNC_DECL float2x2 lerp(const float2x2& lhs, const float2x2& rhs, float t);
 NEO_FUNC_DECL float3x3 lerp(const float3x3& lhs, const float3x3& rhs, float t);
 NEO_FUNC_DECL float4x4 lerp(const float4x4& lhs, const float4x4& rhs, float t);
 
+NEO_FUNC_DECL float2 min(const float2& lhs, const float2& rhs);
+NEO_FUNC_DECL float3 min(const float3& lhs, const float3& rhs);
+NEO_FUNC_DECL float4 min(const float4& lhs, const float4& rhs);
+NEO_FUNC_DECL float2 max(const float2& lhs, const float2& rhs);
+NEO_FUNC_DECL float3 max(const float3& lhs, const float3& rhs);
+NEO_FUNC_DECL float4 max(const float4& lhs, const float4& rhs);
+NEO_FUNC_DECL float2 abs(const float2& vector);
+NEO_FUNC_DECL float3 abs(const float3& vector);
+NEO_FUNC_DECL float4 abs(const float4& vector);
+NEO_FUNC_DECL float2 clamp(const float2& vector, const float2& lower, const float2& upper);
+NEO_FUNC_DECL float3 clamp(const float3& vector, const float3& lower, const float3& upper);
+NEO_FUNC_DECL float4 clamp(const float4& vector, const float4& lower, const float4& upper);
+
+NEO_FUNC_DECL uint32_t morton30(const float3& position, const float3& lower, const float3& upper);
+NEO_FUNC_DECL uint64_t morton63(const float3& position, const float3& lower, const float3& upper);
+
+NEO_FUNC_DECL void unproject(const float4x4& projection, const float4x4& view, const float3* ndc, float3* positions, size_t count);
+NEO_FUNC_DECL void unproject(const float4x4& projection, const float4x4& view, const float* depth, int width, int height, float3* positions);
+
+NEO_BATCH_FUNC_DECL void sincos(const float* angles, float* sines, float* cosines, size_t count);
+
+NEO_BATCH_FUNC_DECL void det(const float2x2* matrices, float* determinants, size_t count);
+NEO_BATCH_FUNC_DECL void det(const float3x3* matrices, float* determinants, size_t count);
+NEO_BATCH_FUNC_DECL void inverse(const float2x2* matrices, float2x2* inverses, bool* singular, size_t count);
+NEO_BATCH_FUNC_DECL void inverse(const float3x3* matrices, float3x3* inverses, bool* singular, size_t count);
+NEO_BATCH_FUNC_DECL void multiply(const float2x2* lhs, const float2x2* rhs, float2x2* products, size_t count);
+NEO_BATCH_FUNC_DECL void multiply(const float3x3* lhs, const float3x3* rhs, float3x3* products, size_t count);
+NEO_BATCH_FUNC_DECL void multiply(const float2x2* matrices, const float2* vectors, float2* products, size_t count);
+NEO_BATCH_FUNC_DECL void multiply(const float3x3* matrices, const float3* vectors, float3* products, size_t count);
+NEO_BATCH_FUNC_DECL void normal_matrix(const float4x4* matrices, float3x3* normal_matrices, size_t count);
+NEO_BATCH_FUNC_DECL void transform_normals(const float3x3& matrix, const float3* normals, float3* transformed, size_t count);
+NEO_BATCH_FUNC_DECL void transform_normals(const float3x3* matrices, const float3* normals, float3* transformed, size_t count);
+
+NEO_BATCH_FUNC_DECL void symmetric_eigen(const float3x3* matrices, float3* values, float3x3* vectors, size_t count);
+NEO_BATCH_FUNC_DECL void svd(const float3x3* matrices, float3x3* u, float3* sigma, float3x3* v, size_t count);
+NEO_BATCH_FUNC_DECL void polar(const float3x3* matrices, float3x3* rotations, float3x3* stretches, size_t count);
+NEO_BATCH_FUNC_DECL void decompose(const float4x4* matrices, float3* translations, float3x3* rotations, float3* scales, size_t count);
+NEO_BATCH_FUNC_DECL void decompose(const float4x4* matrices, float3* translations, float4* rotations, float3* scales, size_t count);
+
+NEO_BATCH_FUNC_DECL float2 sum(const float2* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float3 sum(const float3* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float4 sum(const float4* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float2 min(const float2* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float3 min(const float3* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float4 min(const float4* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float2 max(const float2* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float3 max(const float3* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float4 max(const float4* vectors, size_t count);
+NEO_BATCH_FUNC_DECL void bounds(const float2* vectors, size_t count, float2& lower, float2& upper);
+NEO_BATCH_FUNC_DECL void bounds(const float3* vectors, size_t count, float3& lower, float3& upper);
+NEO_BATCH_FUNC_DECL void bounds(const float4* vectors, size_t count, float4& lower, float4& upper);
+NEO_BATCH_FUNC_DECL float2 mean(const float2* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float3 mean(const float3* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float4 mean(const float4* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float2x2 covariance(const float2* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float3x3 covariance(const float3* vectors, size_t count);
+NEO_BATCH_FUNC_DECL float4x4 covariance(const float4* vectors, size_t count);
+
+NEO_BATCH_FUNC_DECL void morton30(const float3* positions, const float3& lower, const float3& upper, uint32_t* codes, size_t count);
+NEO_BATCH_FUNC_DECL void morton63(const float3* positions, const float3& lower, const float3& upper, uint64_t* codes, size_t count);
+NEO_BATCH_FUNC_DECL void radix_sort(uint32_t* keys, uint32_t* values, size_t count);
+NEO_BATCH_FUNC_DECL void radix_sort(uint64_t* keys, uint32_t* values, size_t count);
+
+NEO_BATCH_FUNC_DECL void blend(const float* const* poses, const float* weights, size_t pose_count, float* result, size_t count);
+NEO_BATCH_FUNC_DECL void blend(const float3* const* poses, const float* weights, size_t pose_count, float3* result, size_t count);
+NEO_BATCH_FUNC_DECL void blend(const float4* const* poses, const float* weights, size_t pose_count, float4* result, size_t count);
+NEO_BATCH_FUNC_DECL void blend_rotations(const float4* const* poses, const float* weights, size_t pose_count, float4* result, size_t count);
+
 }
 
 #endif
@@ -324,3 +433,22 @@ NEO_FUNC_DECL float4x4 lerp(const float4x4& lhs, const float4x4& rhs, float t);
 #include "float3x3.hpp"
 #include "float4x4.hpp"
 #include "functions.hpp"
+#include "decomposition.hpp"
+#include "reduction.hpp"
+#include "kd_tree.hpp"
+#include "spatial_hash.hpp"
+#include "morton.hpp"
+#include "sort.hpp"
+#include "animation.hpp"
+#include "spline.hpp"
+#include "pipeline.hpp"
+#include "mesh_io.hpp"
+#include "mesh_adjacency.hpp"
+#include "obb.hpp"
+#include "broadphase.hpp"
+#include "particles.hpp"
+#include "random.hpp"
+#include "noise.hpp"
+#include "triple_buffer.hpp"
+#include "compression.hpp"
+#include "color.hpp"
@@ -0,0 +1,237 @@
+#ifndef NOISE_HPP
+#define NOISE_HPP
+
+#include <stdint.h>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+enum noise_basis { PERLIN, SIMPLEX };
+
+// Fractal sums add octaves of the basis at growing frequency and shrinking amplitude, normalized by
+// the total amplitude. Ridged octaves contribute (1 - |noise|)^2, giving values in [0, 1].
+struct noise_parameters {
+    noise_basis basis;
+    int octaves;
+    float lacunarity, gain;
+    bool ridged;
+    uint32_t seed;
+};
+
+// Perlin's 2, 3 and 4 dimensional gradient sets generated from a hash: the low N bits choose the
+// signs and the next two bits the component set to zero, if any is below N. Only sign and mask
+// operations are needed, no table lookups.
+template <int N, class V>
+inline V gradient_dot(const typename V::int_type& hash, const V* offset) {
+    typedef typename V::int_type I;
+
+    V result = V(0.0f);
+    I zero = (hash >> N) & I(3);
+    for (int k = 0; k < N; k++) {
+        I sign = (hash << (31 - k)) & I((int32_t)0x80000000u);
+        V term = as_float(as_int(offset[k]) ^ sign);
+        result = result + andnot(as_float(zero == I(k)), term);
+    }
+    return result;
+}
+
+template <int N, class I>
+inline I lattice_hash(const I* cell, uint32_t seed) {
+    static const int32_t PRIMES[4] = { (int32_t)0x8DA6B343u, (int32_t)0xD8163841u, (int32_t)0xCB1AB31Fu, (int32_t)0x165667B1u };
+    I hash = I((int32_t)seed);
+    for (int k = 0; k < N; k++) hash = (hash ^ cell[k]) * I(PRIMES[k]);
+    hash = hash ^ hash >> 15;
+    hash = hash * I((int32_t)0x2C1B3C6Du);
+    hash = hash ^ hash >> 12;
+    hash = hash * I((int32_t)0x297A2D39u);
+    return hash ^ hash >> 15;
+}
+
+// Gradient noise interpolated with the quintic fade over the 2^N corners of the lattice cell.
+template <int N, class V>
+inline V perlin(const V* position, uint32_t seed) {
+    typedef typename V::int_type I;
+
+    I cell[N];
+    V fraction[N], fade[N];
+    for (int k = 0; k < N; k++) {
+        V base = floor(position[k]);
+        cell[k] = to_int(base);
+        fraction[k] = position[k] - base;
+        fade[k] = fraction[k] * fraction[k] * fraction[k] * fmadd(fraction[k], fmadd(fraction[k], V(6.0f), V(-15.0f)), V(10.0f));
+    }
+
+    V values[1 << N];
+    for (int corner = 0; corner < (1 << N); corner++) {
+        I corner_cell[N];
+        V offset[N];
+        for (int k = 0; k < N; k++) {
+            int bit = corner >> k & 1;
+            corner_cell[k] = cell[k] + I(bit);
+            offset[k] = fraction[k] - V((float)bit);
+        }
+        values[corner] = gradient_dot<N>(lattice_hash<N>(corner_cell, seed), offset);
+    }
+    for (int k = 0; k < N; k++) {
+        int step = 1 << k;
+        for (int corner = 0; corner < (1 << N); corner += 2 * step) values[corner] = fmadd(values[corner + step] - values[corner], fade[k], values[corner]);
+    }
+
+    const float SCALE[5] = { 0.0f, 0.0f, 1.0f, 0.88f, 0.85f };
+    return values[0] * V(SCALE[N]);
+}
+
+// Simplex noise: the N + 1 corners of the simplex containing the point, found by ranking the
+// offsets within the skewed cell, each contribute a radially attenuated gradient. The kernel
+// radius keeps the result continuous in every dimension.
+template <int N, class V>
+inline V simplex(const V* position, uint32_t seed) {
+    typedef typename V::int_type I;
+
+    const float SKEW[5] = { 0.0f, 0.0f, 0.36602540378f, 1.0f / 3.0f, 0.30901699437f };
+    const float UNSKEW[5] = { 0.0f, 0.0f, 0.21132486540f, 1.0f / 6.0f, 0.13819660112f };
+    const float SCALE[5] = { 0.0f, 0.0f, 70.0f, 62.0f, 62.0f };
+
+    V sum = position[0];
+    for (int k = 1; k < N; k++) sum = sum + position[k];
+    V skew = sum * V(SKEW[N]);
+
+    I cell[N];
+    V base[N];
+    for (int k = 0; k < N; k++) {
+        base[k] = floor(position[k] + skew);
+        cell[k] = to_int(base[k]);
+    }
+    V cell_sum = base[0];
+    for (int k = 1; k < N; k++) cell_sum = cell_sum + base[k];
+    V unskew = cell_sum * V(UNSKEW[N]);
+
+    V origin[N], rank[N];
+    for (int k = 0; k < N; k++) {
+        origin[k] = position[k] - (base[k] - unskew);
+        rank[k] = V(0.0f);
+    }
+    for (int k = 0; k < N; k++) {
+        for (int j = k + 1; j < N; j++) {
+            V larger = origin[k] > origin[j];
+            rank[k] = rank[k] + (larger & V(1.0f));
+            rank[j] = rank[j] + andnot(larger, V(1.0f));
+        }
+    }
+
+    V result = V(0.0f);
+    for (int corner = 0; corner <= N; corner++) {
+        I corner_cell[N];
+        V offset[N], distance_squared = V(0.0f);
+        for (int k = 0; k < N; k++) {
+            V step = rank[k] >= V((float)(N - corner));
+            corner_cell[k] = cell[k] + (as_int(step) & I(1));
+            offset[k] = origin[k] - (step & V(1.0f)) + V(corner * UNSKEW[N]);
+            distance_squared = fmadd(offset[k], offset[k], distance_squared);
+        }
+        V falloff = max(V(0.5f) - distance_squared, V(0.0f));
+        falloff = falloff * falloff;
+        result = fmadd(falloff * falloff, gradient_dot<N>(lattice_hash<N>(corner_cell, seed), offset), result);
+    }
+    return result * V(SCALE[N]);
+}
+
+template <int N>
+struct noise_kernel {
+    template <class V>
+    static void run(const float* points, noise_parameters parameters, float* values, size_t begin, size_t end) {
+        float normalization = 0.0f, amplitude = 1.0f;
+        for (int octave = 0; octave < parameters.octaves; octave++, amplitude *= parameters.gain) normalization += amplitude;
+        V scale = V(1.0f / normalization);
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V position[N];
+            simd::load_interleaved(points + i * N, position, N, lanes);
+
+            V result = V(0.0f);
+            float frequency = 1.0f;
+            amplitude = 1.0f;
+            for (int octave = 0; octave < parameters.octaves; octave++) {
+                // Octaves are shifted apart so that their lattices, and the zeros at lattice points,
+                // do not line up.
+                V sample[N];
+                for (int k = 0; k < N; k++) sample[k] = fmadd(position[k], V(frequency), V(octave * (17.31f + k * 5.17f)));
+                uint32_t seed = parameters.seed + (uint32_t)octave * 0x9E3779B9u;
+                V value = parameters.basis == PERLIN ? perlin<N>(sample, seed) : simplex<N>(sample, seed);
+                if (parameters.ridged) {
+                    value = V(1.0f) - abs(value);
+                    value = value * value;
+                }
+                result = fmadd(value, V(amplitude), result);
+                frequency *= parameters.lacunarity;
+                amplitude *= parameters.gain;
+            }
+            (result * scale).store(values + i, lanes);
+        }
+    }
+};
+
+template <int N>
+inline void noise(const float* points, float* values, size_t count, const noise_parameters& parameters) {
+    parallel_for(count, 1 << 12, [&](size_t begin, size_t end) {
+        simd::dispatch<noise_kernel<N> >(points, parameters, values, begin, end);
+    });
+}
+
+template <int N>
+inline float noise(const float* point, const noise_parameters& parameters) {
+    float value;
+    simd::dispatch<noise_kernel<N> >(point, parameters, &value, (size_t)0, (size_t)1);
+    return value;
+}
+
+inline noise_parameters noise_basis_parameters(noise_basis basis, uint32_t seed) {
+    noise_parameters parameters = { basis, 1, 2.0f, 0.5f, false, seed };
+    return parameters;
+}
+
+inline noise_parameters noise_fractal_parameters(int octaves, float lacunarity, float gain, bool ridged, uint32_t seed) {
+    noise_parameters parameters = { SIMPLEX, octaves < 1 ? 1 : octaves, lacunarity, gain, ridged, seed };
+    return parameters;
+}
+
+}
+
+// Gradient (Perlin) and simplex noise in roughly [-1, 1]; different seeds give unrelated fields.
+// Backends with fused multiply-add agree with the others to within about 1e-6.
+NEO_BATCH_FUNC_DEF float perlin(const float2& point, uint32_t seed = 0) { return detail::noise<2>(&point.x, detail::noise_basis_parameters(detail::PERLIN, seed)); }
+NEO_BATCH_FUNC_DEF float perlin(const float3& point, uint32_t seed = 0) { return detail::noise<3>(&point.x, detail::noise_basis_parameters(detail::PERLIN, seed)); }
+NEO_BATCH_FUNC_DEF float perlin(const float4& point, uint32_t seed = 0) { return detail::noise<4>(&point.x, detail::noise_basis_parameters(detail::PERLIN, seed)); }
+NEO_BATCH_FUNC_DEF float simplex(const float2& point, uint32_t seed = 0) { return detail::noise<2>(&point.x, detail::noise_basis_parameters(detail::SIMPLEX, seed)); }
+NEO_BATCH_FUNC_DEF float simplex(const float3& point, uint32_t seed = 0) { return detail::noise<3>(&point.x, detail::noise_basis_parameters(detail::SIMPLEX, seed)); }
+NEO_BATCH_FUNC_DEF float simplex(const float4& point, uint32_t seed = 0) { return detail::noise<4>(&point.x, detail::noise_basis_parameters(detail::SIMPLEX, seed)); }
+
+NEO_BATCH_FUNC_DEF void perlin(const float2* points, float* values, size_t count, uint32_t seed = 0) { detail::noise<2>(&points[0].x, values, count, detail::noise_basis_parameters(detail::PERLIN, seed)); }
+NEO_BATCH_FUNC_DEF void perlin(const float3* points, float* values, size_t count, uint32_t seed = 0) { detail::noise<3>(&points[0].x, values, count, detail::noise_basis_parameters(detail::PERLIN, seed)); }
+NEO_BATCH_FUNC_DEF void perlin(const float4* points, float* values, size_t count, uint32_t seed = 0) { detail::noise<4>(&points[0].x, values, count, detail::noise_basis_parameters(detail::PERLIN, seed)); }
+NEO_BATCH_FUNC_DEF void simplex(const float2* points, float* values, size_t count, uint32_t seed = 0) { detail::noise<2>(&points[0].x, values, count, detail::noise_basis_parameters(detail::SIMPLEX, seed)); }
+NEO_BATCH_FUNC_DEF void simplex(const float3* points, float* values, size_t count, uint32_t seed = 0) { detail::noise<3>(&points[0].x, values, count, detail::noise_basis_parameters(detail::SIMPLEX, seed)); }
+NEO_BATCH_FUNC_DEF void simplex(const float4* points, float* values, size_t count, uint32_t seed = 0) { detail::noise<4>(&points[0].x, values, count, detail::noise_basis_parameters(detail::SIMPLEX, seed)); }
+
+// Fractal sums of simplex noise. fbm stays in roughly [-1, 1], ridged in [0, 1]. Fewer than one octave
+// counts as one.
+NEO_BATCH_FUNC_DEF float fbm(const float2& point, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { return detail::noise<2>(&point.x, detail::noise_fractal_parameters(octaves, lacunarity, gain, false, seed)); }
+NEO_BATCH_FUNC_DEF float fbm(const float3& point, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { return detail::noise<3>(&point.x, detail::noise_fractal_parameters(octaves, lacunarity, gain, false, seed)); }
+NEO_BATCH_FUNC_DEF float fbm(const float4& point, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { return detail::noise<4>(&point.x, detail::noise_fractal_parameters(octaves, lacunarity, gain, false, seed)); }
+NEO_BATCH_FUNC_DEF float ridged(const float2& point, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { return detail::noise<2>(&point.x, detail::noise_fractal_parameters(octaves, lacunarity, gain, true, seed)); }
+NEO_BATCH_FUNC_DEF float ridged(const float3& point, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { return detail::noise<3>(&point.x, detail::noise_fractal_parameters(octaves, lacunarity, gain, true, seed)); }
+NEO_BATCH_FUNC_DEF float ridged(const float4& point, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { return detail::noise<4>(&point.x, detail::noise_fractal_parameters(octaves, lacunarity, gain, true, seed)); }
+
+NEO_BATCH_FUNC_DEF void fbm(const float2* points, float* values, size_t count, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { detail::noise<2>(&points[0].x, values, count, detail::noise_fractal_parameters(octaves, lacunarity, gain, false, seed)); }
+NEO_BATCH_FUNC_DEF void fbm(const float3* points, float* values, size_t count, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { detail::noise<3>(&points[0].x, values, count, detail::noise_fractal_parameters(octaves, lacunarity, gain, false, seed)); }
+NEO_BATCH_FUNC_DEF void fbm(const float4* points, float* values, size_t count, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { detail::noise<4>(&points[0].x, values, count, detail::noise_fractal_parameters(octaves, lacunarity, gain, false, seed)); }
+NEO_BATCH_FUNC_DEF void ridged(const float2* points, float* values, size_t count, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { detail::noise<2>(&points[0].x, values, count, detail::noise_fractal_parameters(octaves, lacunarity, gain, true, seed)); }
+NEO_BATCH_FUNC_DEF void ridged(const float3* points, float* values, size_t count, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { detail::noise<3>(&points[0].x, values, count, detail::noise_fractal_parameters(octaves, lacunarity, gain, true, seed)); }
+NEO_BATCH_FUNC_DEF void ridged(const float4* points, float* values, size_t count, int octaves, float lacunarity = 2.0f, float gain = 0.5f, uint32_t seed = 0) { detail::noise<4>(&points[0].x, values, count, detail::noise_fractal_parameters(octaves, lacunarity, gain, true, seed)); }
+
+}
+
+#endif
@@ -0,0 +1,344 @@
+#ifndef OBB_HPP
+#define OBB_HPP
+
+#include <limits>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace simd {
+
+// Oriented box tests written once for T = float and for SIMD lanes. A box is fifteen scalars:
+// center, the three orientation columns and the half extents.
+
+// Rotation r[3 * i + j] = dot(a_i, b_j) taking b's frame into a's and b's center in a's frame.
+template <class T>
+NEO_FUNC_DEF void obb_relative(const T* a, const T* b, T* r, T* t) {
+    const T* a_axes = a + 3;
+    const T* b_axes = b + 3;
+    T offset[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    for (int i = 0; i < 3; i++) {
+        const T* axis = a_axes + 3 * i;
+        for (int j = 0; j < 3; j++) {
+            const T* other = b_axes + 3 * j;
+            r[3 * i + j] = fmadd(axis[0], other[0], fmadd(axis[1], other[1], axis[2] * other[2]));
+        }
+        t[i] = fmadd(axis[0], offset[0], fmadd(axis[1], offset[1], axis[2] * offset[2]));
+    }
+}
+
+// Separating axis test of Gottschalk et al. over the face normals of both boxes and the nine edge
+// cross products, evaluated from the relative rotation without forming the axes. Returns the largest
+// gap between projections, which is positive exactly when the boxes are disjoint. The cross axes are
+// not normalized, so the value is not a distance. Absolute rotation entries are padded so that
+// parallel edges, whose cross product vanishes, never produce a false separation.
+template <class T>
+NEO_FUNC_DEF T obb_separation(const T* a_extents, const T* b_extents, const T* r, const T* t) {
+    T absolute[9];
+    for (int k = 0; k < 9; k++) absolute[k] = abs(r[k]) + T(1e-6f);
+
+    T gap = T(-std::numeric_limits<float>::infinity());
+    for (int i = 0; i < 3; i++) {
+        T rb = fmadd(b_extents[0], absolute[3 * i], fmadd(b_extents[1], absolute[3 * i + 1], b_extents[2] * absolute[3 * i + 2]));
+        gap = max(gap, abs(t[i]) - (a_extents[i] + rb));
+    }
+    for (int j = 0; j < 3; j++) {
+        T ra = fmadd(a_extents[0], absolute[j], fmadd(a_extents[1], absolute[3 + j], a_extents[2] * absolute[6 + j]));
+        T projection = fmadd(t[0], r[j], fmadd(t[1], r[3 + j], t[2] * r[6 + j]));
+        gap = max(gap, abs(projection) - (ra + b_extents[j]));
+    }
+    for (int i = 0; i < 3; i++) {
+        int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+        for (int j = 0; j < 3; j++) {
+            int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+            T ra = fmadd(a_extents[i1], absolute[3 * i2 + j], a_extents[i2] * absolute[3 * i1 + j]);
+            T rb = fmadd(b_extents[j1], absolute[3 * i + j2], b_extents[j2] * absolute[3 * i + j1]);
+            T projection = fnmadd(t[i1], r[3 * i2 + j], t[i2] * r[3 * i1 + j]);
+            gap = max(gap, abs(projection) - (ra + rb));
+        }
+    }
+    return gap;
+}
+
+template <class T>
+NEO_FUNC_DEF T obb_distance_squared(const T* box, const T* point) {
+    T offset[3] = { point[0] - box[0], point[1] - box[1], point[2] - box[2] };
+    T result = T(0.0f);
+    for (int i = 0; i < 3; i++) {
+        const T* axis = box + 3 + 3 * i;
+        T local = fmadd(axis[0], offset[0], fmadd(axis[1], offset[1], axis[2] * offset[2]));
+        T excess = max(abs(local) - box[12 + i], T(0.0f));
+        result = fmadd(excess, excess, result);
+    }
+    return result;
+}
+
+// Slab test in the box frame. distance is the ray parameter where the ray enters the box, or zero
+// when it starts inside. Directions near zero along an axis are nudged so that no lane divides by
+// zero; the ray then hits only if it already lies within that slab.
+template <class T>
+NEO_FUNC_DEF auto obb_ray(const T* box, const T* origin, const T* direction, T& distance) -> decltype(T() <= T()) {
+    T offset[3] = { origin[0] - box[0], origin[1] - box[1], origin[2] - box[2] };
+    T entry = T(0.0f), exit = T(std::numeric_limits<float>::infinity());
+    for (int i = 0; i < 3; i++) {
+        const T* axis = box + 3 + 3 * i;
+        T local = fmadd(axis[0], offset[0], fmadd(axis[1], offset[1], axis[2] * offset[2]));
+        T speed = fmadd(axis[0], direction[0], fmadd(axis[1], direction[1], axis[2] * direction[2]));
+        T inverse = T(1.0f) / select(abs(speed) < T(1e-30f), T(1e-30f), speed);
+        T t0 = (-box[12 + i] - local) * inverse;
+        T t1 = (box[12 + i] - local) * inverse;
+        entry = max(entry, min(t0, t1));
+        exit = min(exit, max(t0, t1));
+    }
+    distance = entry;
+    return entry <= exit;
+}
+
+}
+
+struct obb {
+
+    float3 center;
+    float3x3 orientation;
+    float3 half_extents;
+
+    NEO_FUNC_DECL obb(): center(0.0f), half_extents(0.0f) { }
+    NEO_FUNC_DECL obb(const float3& center, const float3x3& orientation, const float3& half_extents): center(center), orientation(orientation), half_extents(half_extents) { }
+
+    // Axes are the principal directions of the points' covariance, extents are fitted to the points.
+    static NEO_BATCH_FUNC_DECL obb from_points(const float3* points, size_t count);
+
+    NEO_FUNC_DECL float3 closest_point(const float3& point) const;
+
+    NEO_FUNC_DECL bool intersects(const obb& other) const;
+    NEO_FUNC_DECL bool intersects_aabb(const float3& lower, const float3& upper) const;
+    NEO_FUNC_DECL bool intersects_sphere(const float3& sphere_center, float radius) const;
+    // distance is the ray parameter of the entry point, zero if origin is inside.
+    NEO_FUNC_DECL bool intersects_ray(const float3& origin, const float3& direction, float& distance) const;
+
+};
+
+NEO_FUNC_DEF float3 obb::closest_point(const float3& point) const {
+    float3 offset = point - center, result = center;
+    for (int i = 0; i < 3; i++) {
+        float local = dot(orientation[i], offset);
+        result += orientation[i] * simd::min(simd::max(local, -half_extents[i]), half_extents[i]);
+    }
+    return result;
+}
+
+NEO_FUNC_DEF bool obb::intersects(const obb& other) const {
+    float r[9], t[3];
+    simd::obb_relative(&center.x, &other.center.x, r, t);
+    return simd::obb_separation(&half_extents.x, &other.half_extents.x, r, t) <= 0.0f;
+}
+
+NEO_FUNC_DEF bool obb::intersects_aabb(const float3& lower, const float3& upper) const {
+    return intersects(obb((lower + upper) * 0.5f, float3x3(), (upper - lower) * 0.5f));
+}
+
+NEO_FUNC_DEF bool obb::intersects_sphere(const float3& sphere_center, float radius) const {
+    return simd::obb_distance_squared(&center.x, &sphere_center.x) <= radius * radius;
+}
+
+NEO_FUNC_DEF bool obb::intersects_ray(const float3& origin, const float3& direction, float& distance) const {
+    return simd::obb_ray(&center.x, &origin.x, &direction.x, distance);
+}
+
+namespace detail {
+
+struct projected_bounds {
+    float lower[3], upper[3];
+};
+
+// Extents of the points along three axes.
+struct projected_bounds_kernel {
+    template <class V>
+    static projected_bounds run(const float3* points, float3x3 axes, size_t begin, size_t end) {
+        V a[9];
+        for (int k = 0; k < 9; k++) a[k] = V(axes[k / 3][k % 3]);
+        V lower[3], upper[3];
+        for (int c = 0; c < 3; c++) {
+            lower[c] = V(std::numeric_limits<float>::infinity());
+            upper[c] = V(-std::numeric_limits<float>::infinity());
+        }
+
+        size_t i = begin;
+        for (; i + V::width < end; i += V::width) {
+            V p[4];
+            load_transposed4(&points[i].x, 3, p);
+            for (int c = 0; c < 3; c++) {
+                V local = fmadd(a[3 * c], p[0], fmadd(a[3 * c + 1], p[1], a[3 * c + 2] * p[2]));
+                lower[c] = min(lower[c], local);
+                upper[c] = max(upper[c], local);
+            }
+        }
+
+        projected_bounds result;
+        for (int c = 0; c < 3; c++) {
+            float lower_lanes[V::width], upper_lanes[V::width];
+            lower[c].store(lower_lanes);
+            upper[c].store(upper_lanes);
+            result.lower[c] = lower_lanes[0];
+            result.upper[c] = upper_lanes[0];
+            for (int l = 1; l < V::width; l++) {
+                result.lower[c] = simd::min(result.lower[c], lower_lanes[l]);
+                result.upper[c] = simd::max(result.upper[c], upper_lanes[l]);
+            }
+        }
+        for (; i < end; i++) {
+            for (int c = 0; c < 3; c++) {
+                float local = dot(axes[c], points[i]);
+                result.lower[c] = simd::min(result.lower[c], local);
+                result.upper[c] = simd::max(result.upper[c], local);
+            }
+        }
+        return result;
+    }
+};
+
+// One box against many, one candidate per lane. The single box is broadcast once per range.
+struct obb_kernel {
+    template <class V>
+    static void run(const obb& box, const obb* others, bool* results, size_t begin, size_t end) {
+        const float* scalars = &box.center.x;
+        V a[15];
+        for (int k = 0; k < 15; k++) a[k] = V(scalars[k]);
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V b[15], r[9], t[3];
+            simd::load_interleaved(&others[i].center.x, b, 15, lanes);
+            simd::obb_relative(a, b, r, t);
+            int flags = mask_bits(simd::obb_separation(a + 12, b + 12, r, t) <= V(0.0f));
+            for (int l = 0; l < lanes; l++) results[i + l] = (flags >> l & 1) != 0;
+        }
+    }
+};
+
+// With the box as the second operand, the relative rotation is the box orientation itself and
+// only the offset depends on the lane.
+struct obb_aabb_kernel {
+    template <class V>
+    static void run(const obb& box, const float3* lower, const float3* upper, bool* results, size_t begin, size_t end) {
+        V r[9], center[3], extents[3];
+        for (int k = 0; k < 9; k++) r[k] = V(box.orientation[k % 3][k / 3]);
+        for (int c = 0; c < 3; c++) {
+            center[c] = V(box.center[c]);
+            extents[c] = V(box.half_extents[c]);
+        }
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V l[3], u[3], half[3], t[3];
+            simd::load_interleaved(&lower[i].x, l, 3, lanes);
+            simd::load_interleaved(&upper[i].x, u, 3, lanes);
+            for (int c = 0; c < 3; c++) {
+                half[c] = (u[c] - l[c]) * V(0.5f);
+                t[c] = center[c] - (l[c] + half[c]);
+            }
+            int flags = mask_bits(simd::obb_separation(half, extents, r, t) <= V(0.0f));
+            for (int k = 0; k < lanes; k++) results[i + k] = (flags >> k & 1) != 0;
+        }
+    }
+};
+
+struct obb_sphere_kernel {
+    template <class V>
+    static void run(const obb& box, const float3* centers, const float* radii, bool* results, size_t begin, size_t end) {
+        const float* scalars = &box.center.x;
+        V a[15];
+        for (int k = 0; k < 15; k++) a[k] = V(scalars[k]);
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V p[3];
+            simd::load_interleaved(&centers[i].x, p, 3, lanes);
+            V radius = V::load(radii + i, lanes);
+            int flags = mask_bits(simd::obb_distance_squared(a, p) <= radius * radius);
+            for (int l = 0; l < lanes; l++) results[i + l] = (flags >> l & 1) != 0;
+        }
+    }
+};
+
+struct obb_ray_kernel {
+    template <class V>
+    static void run(const obb& box, const float3* origins, const float3* directions, bool* hits, float* distances, size_t begin, size_t end) {
+        const float* scalars = &box.center.x;
+        V a[15];
+        for (int k = 0; k < 15; k++) a[k] = V(scalars[k]);
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V o[3], d[3], distance;
+            simd::load_interleaved(&origins[i].x, o, 3, lanes);
+            simd::load_interleaved(&directions[i].x, d, 3, lanes);
+            int flags = mask_bits(simd::obb_ray(a, o, d, distance));
+            for (int l = 0; l < lanes; l++) hits[i + l] = (flags >> l & 1) != 0;
+            if (distances != nullptr) distance.store(distances + i, lanes);
+        }
+    }
+};
+
+}
+
+NEO_BATCH_FUNC_DEF obb obb::from_points(const float3* points, size_t count) {
+    if (count == 0) return obb();
+
+    float3 values;
+    float3x3 axes;
+    covariance(points, count).symmetric_eigen(values, axes);
+
+    detail::projected_bounds identity;
+    for (int c = 0; c < 3; c++) {
+        identity.lower[c] = std::numeric_limits<float>::infinity();
+        identity.upper[c] = -std::numeric_limits<float>::infinity();
+    }
+    detail::projected_bounds extent = parallel_reduce(count, 1 << 15, identity,
+        [&](size_t begin, size_t end) { return simd::dispatch<detail::projected_bounds_kernel>(points, axes, begin, end); },
+        [](const detail::projected_bounds& lhs, const detail::projected_bounds& rhs) {
+            detail::projected_bounds result;
+            for (int c = 0; c < 3; c++) {
+                result.lower[c] = simd::min(lhs.lower[c], rhs.lower[c]);
+                result.upper[c] = simd::max(lhs.upper[c], rhs.upper[c]);
+            }
+            return result;
+        });
+
+    float3 local_center, half_extents;
+    for (int c = 0; c < 3; c++) {
+        local_center[c] = 0.5f * (extent.lower[c] + extent.upper[c]);
+        half_extents[c] = 0.5f * (extent.upper[c] - extent.lower[c]);
+    }
+    return obb(axes * local_center, axes, half_extents);
+}
+
+// Batched tests of one box against many candidates; results hold one flag per candidate.
+NEO_BATCH_FUNC_DEF void intersects(const obb& box, const obb* others, bool* results, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::obb_kernel>(box, others, results, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void intersects_aabb(const obb& box, const float3* lower, const float3* upper, bool* results, size_t count) {
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::obb_aabb_kernel>(box, lower, upper, results, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void intersects_sphere(const obb& box, const float3* centers, const float* radii, bool* results, size_t count) {
+    parallel_for(count, 1 << 15, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::obb_sphere_kernel>(box, centers, radii, results, begin, end);
+    });
+}
+
+// distances (which may be null) receive the entry parameter of every ray, meaningful where hit.
+NEO_BATCH_FUNC_DEF void intersects_ray(const obb& box, const float3* origins, const float3* directions, bool* hits, float* distances, size_t count) {
+    parallel_for(count, 1 << 15, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::obb_ray_kernel>(box, origins, directions, hits, distances, begin, end);
+    });
+}
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace neo {
+namespace detail {
+
+// Persistent workers that split each job into tasks claimed through an atomic counter. The calling
+// thread takes part in the work; jobs submitted while another one is running (nested or from a
+// second thread) are executed inline instead of waiting for the pool. The first exception thrown by
+// a task cancels the tasks not yet started and is rethrown on the calling thread once every worker
+// has left the job.
+class thread_pool {
+
+public:
+
+    static thread_pool& instance() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    unsigned size() const { return (unsigned)workers.size() + 1; }
+
+    void run(size_t tasks, const std::function<void(size_t)>& task) {
+        bool idle = false;
+        if (tasks < 2 || workers.empty() || !busy.compare_exchange_strong(idle, true)) {
+            for (size_t i = 0; i < tasks; i++) task(i);
+            return;
+        }
+
+        release_on_exit release(busy);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            job_tasks = tasks;
+            next_task = 0;
+            pending = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        work();
+
+        std::exception_ptr thrown;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return pending == 0; });
+            job = nullptr;
+            thrown = failure;
+            failure = nullptr;
+        }
+        if (thrown) std::rethrow_exception(thrown);
+    }
+
+private:
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    std::atomic<bool> busy;
+    std::atomic<size_t> next_task;
+    const std::function<void(size_t)>* job;
+    size_t job_tasks, pending, generation;
+    std::exception_ptr failure;
+    bool stopping;
+
+    struct release_on_exit {
+        std::atomic<bool>& flag;
+        explicit release_on_exit(std::atomic<bool>& flag): flag(flag) { }
+        ~release_on_exit() { flag = false; }
+    };
+
+    thread_pool(): busy(false), next_task(0), job(nullptr), job_tasks(0), pending(0), generation(0), stopping(false) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        for (unsigned i = 1; i < hardware; i++) workers.emplace_back([this] { loop(); });
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    }
+
+    thread_pool(const thread_pool&);
+    thread_pool& operator=(const thread_pool&);
+
+    void work() {
+        try {
+            for (size_t i = next_task++; i < job_tasks; i = next_task++) (*job)(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) failure = std::current_exception();
+            next_task = job_tasks;
+        }
+    }
+
+    void loop() {
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            work();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0) done.notify_one();
+            }
+        }
+    }
+
+};
+
+}
+
+inline unsigned thread_count() {
+    return detail::thread_pool::instance().size();
+}
+
+// Calls body(begin, end) for consecutive ranges of at most grain items, spread over the thread pool.
+// A grain of 0 counts as 1. An exception thrown by body propagates to the caller after the other
+// ranges in flight have finished; ranges not yet started are skipped.
+template <class F>
+inline void parallel_for(size_t count, size_t grain, const F& body) {
+    if (grain == 0) grain = 1;
+    size_t ranges = (count + grain - 1) / grain;
+    detail::thread_pool::instance().run(ranges, [&](size_t range) {
+        size_t begin = range * grain;
+        body(begin, begin + grain < count ? begin + grain : count);
+    });
+}
+
+// Maps each range to a partial result, then combines neighbouring partials pairwise so that the
+// combination order is a balanced tree independent of the number of threads.
+template <class T, class Map, class Combine>
+inline T parallel_reduce(size_t count, size_t grain, const T& identity, const Map& map, const Combine& combine) {
+    if (grain == 0) grain = 1;
+    size_t ranges = (count + grain - 1) / grain;
+    if (ranges == 0) return identity;
+
+    std::vector<T> partials(ranges, identity);
+    parallel_for(count, grain, [&](size_t begin, size_t end) {
+        partials[begin / grain] = map(begin, end);
+    });
+
+    for (size_t stride = 1; stride < ranges; stride *= 2) {
+        for (size_t i = 0; i + stride < ranges; i += 2 * stride) partials[i] = combine(partials[i], partials[i + stride]);
+    }
+    return partials[0];
+}
+
+}
+
+#endif
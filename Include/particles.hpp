@@ -0,0 +1,205 @@
+#ifndef PARTICLES_HPP
+#define PARTICLES_HPP
+
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+
+// Terms applied during integration. Acceleration is gravity - drag * velocity. Planes are
+// (normal, offset) with unit normals; particles with dot(normal, position) + offset < 0 are pushed
+// back onto the plane and lose their inward velocity, scaled by restitution when bouncing.
+struct particle_terms {
+
+    float3 gravity;
+    float drag;
+    const float4* planes;
+    size_t plane_count;
+    float restitution;
+
+    NEO_FUNC_DECL particle_terms(): gravity(0.0f), drag(0.0f), planes(nullptr), plane_count(0), restitution(0.0f) { }
+
+};
+
+namespace detail {
+
+// One pass over the six component arrays: every float is read and written once, with the
+// integration, drag and all collision planes applied in registers.
+struct integrate_kernel {
+
+    enum method { SEMI_IMPLICIT_EULER, VELOCITY_VERLET };
+
+    template <class V>
+    static void run(float* const* state, float dt, const particle_terms* terms, method type, size_t begin, size_t end) {
+        V gravity[3] = { V(terms->gravity.x), V(terms->gravity.y), V(terms->gravity.z) };
+        V step = V(dt), drag = V(terms->drag);
+        V bounce = V(-1.0f - terms->restitution);
+        const float4* planes = terms->planes;
+        size_t plane_count = terms->plane_count;
+        float* position[3] = { state[0], state[1], state[2] };
+        float* velocity[3] = { state[3], state[4], state[5] };
+
+        // Velocity Verlet with velocity-dependent acceleration solves the implicit velocity update,
+        // v' = (v + dt / 2 * (2 g - drag v)) / (1 + dt / 2 * drag), in closed form.
+        float half_dt = 0.5f * dt;
+        V damping = V((1.0f - half_dt * terms->drag) / (1.0f + half_dt * terms->drag));
+        V impulse = V(2.0f * half_dt / (1.0f + half_dt * terms->drag));
+        V half_step_squared = V(half_dt * dt);
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V p[3], v[3];
+            for (int c = 0; c < 3; c++) {
+                p[c] = lanes == V::width ? V::load(position[c] + i) : V::load(position[c] + i, lanes);
+                v[c] = lanes == V::width ? V::load(velocity[c] + i) : V::load(velocity[c] + i, lanes);
+            }
+
+            if (type == SEMI_IMPLICIT_EULER) {
+                for (int c = 0; c < 3; c++) {
+                    v[c] = fmadd(fnmadd(drag, v[c], gravity[c]), step, v[c]);
+                    p[c] = fmadd(v[c], step, p[c]);
+                }
+            } else {
+                for (int c = 0; c < 3; c++) {
+                    V acceleration = fnmadd(drag, v[c], gravity[c]);
+                    p[c] = fmadd(acceleration, half_step_squared, fmadd(v[c], step, p[c]));
+                    v[c] = fmadd(gravity[c], impulse, v[c] * damping);
+                }
+            }
+
+            for (size_t k = 0; k < plane_count; k++) {
+                const float4& plane = planes[k];
+                V normal[3] = { V(plane.x), V(plane.y), V(plane.z) };
+                V distance = fmadd(normal[0], p[0], fmadd(normal[1], p[1], fmadd(normal[2], p[2], V(plane.w))));
+                V speed = fmadd(normal[0], v[0], fmadd(normal[1], v[1], normal[2] * v[2]));
+                V penetration = min(distance, V(0.0f));
+                V reflection = min(speed, V(0.0f)) & (distance < V(0.0f));
+                for (int c = 0; c < 3; c++) {
+                    p[c] = fnmadd(normal[c], penetration, p[c]);
+                    v[c] = fmadd(normal[c], reflection * bounce, v[c]);
+                }
+            }
+
+            for (int c = 0; c < 3; c++) {
+                if (lanes == V::width) {
+                    p[c].store(position[c] + i);
+                    v[c].store(velocity[c] + i);
+                } else {
+                    p[c].store(position[c] + i, lanes);
+                    v[c].store(velocity[c] + i, lanes);
+                }
+            }
+        }
+    }
+
+};
+
+// Splits float3 records into three component arrays, writing zeros when vectors is null, and back.
+struct deinterleave_kernel {
+    template <class V>
+    static void run(const float* vectors, float* const* components, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V fields[3];
+            if (vectors != nullptr) simd::load_interleaved(vectors + 3 * i, fields, 3, lanes);
+            else fields[0] = fields[1] = fields[2] = V(0.0f);
+            for (int c = 0; c < 3; c++) fields[c].store(components[c] + i, lanes);
+        }
+    }
+};
+
+struct interleave_kernel {
+    template <class V>
+    static void run(const float* const* components, float* vectors, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            V fields[3];
+            for (int c = 0; c < 3; c++) fields[c] = V::load(components[c] + i, lanes);
+            simd::store_interleaved(fields, vectors + 3 * i, 3, lanes);
+        }
+    }
+};
+
+}
+
+// Particle positions and velocities stored as separate x, y and z arrays so that integration
+// streams whole registers.
+class particle_state {
+
+public:
+
+    NEO_BATCH_FUNC_DECL particle_state() { }
+    NEO_BATCH_FUNC_DECL explicit particle_state(size_t count) { resize(count); }
+
+    NEO_BATCH_FUNC_DECL void resize(size_t count);
+    NEO_BATCH_FUNC_DECL size_t size() const { return components[0].size(); }
+
+    // Component arrays of the positions and velocities, axis 0 to 2.
+    NEO_BATCH_FUNC_DECL float* positions(int axis) { return components[axis].data(); }
+    NEO_BATCH_FUNC_DECL const float* positions(int axis) const { return components[axis].data(); }
+    NEO_BATCH_FUNC_DECL float* velocities(int axis) { return components[3 + axis].data(); }
+    NEO_BATCH_FUNC_DECL const float* velocities(int axis) const { return components[3 + axis].data(); }
+
+    // Conversion from and to arrays of float3; velocities may be null, which reads as zero or is
+    // not written.
+    NEO_BATCH_FUNC_DECL void load(const float3* positions, const float3* velocities, size_t count);
+    NEO_BATCH_FUNC_DECL void store(float3* positions, float3* velocities) const;
+
+    // Semi-implicit Euler: v += a * dt, then p += v * dt.
+    NEO_BATCH_FUNC_DECL void integrate_euler(float dt, const particle_terms& terms = particle_terms());
+    // Velocity Verlet: second order in position for constant gravity and drag.
+    NEO_BATCH_FUNC_DECL void integrate_verlet(float dt, const particle_terms& terms = particle_terms());
+
+private:
+
+    std::vector<float> components[6];
+
+    NEO_BATCH_FUNC_DECL void integrate(float dt, const particle_terms& terms, detail::integrate_kernel::method type);
+
+};
+
+NEO_BATCH_FUNC_DEF void particle_state::resize(size_t count) {
+    for (int c = 0; c < 6; c++) components[c].resize(count);
+}
+
+NEO_BATCH_FUNC_DEF void particle_state::load(const float3* positions, const float3* velocities, size_t count) {
+    resize(count);
+    float* state[6];
+    for (int c = 0; c < 6; c++) state[c] = components[c].data();
+    const float* velocity_data = velocities != nullptr ? &velocities[0].x : nullptr;
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::deinterleave_kernel>(&positions[0].x, (float* const*)state, begin, end);
+        simd::dispatch<detail::deinterleave_kernel>(velocity_data, (float* const*)(state + 3), begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void particle_state::store(float3* positions, float3* velocities) const {
+    const float* state[6];
+    for (int c = 0; c < 6; c++) state[c] = components[c].data();
+    parallel_for(size(), 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::interleave_kernel>((const float* const*)state, &positions[0].x, begin, end);
+        if (velocities != nullptr) simd::dispatch<detail::interleave_kernel>((const float* const*)(state + 3), &velocities[0].x, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void particle_state::integrate(float dt, const particle_terms& terms, detail::integrate_kernel::method type) {
+    float* state[6];
+    for (int c = 0; c < 6; c++) state[c] = components[c].data();
+    const particle_terms* shared = &terms;
+    parallel_for(size(), 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::integrate_kernel>((float* const*)state, dt, shared, type, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void particle_state::integrate_euler(float dt, const particle_terms& terms) {
+    integrate(dt, terms, detail::integrate_kernel::SEMI_IMPLICIT_EULER);
+}
+
+NEO_BATCH_FUNC_DEF void particle_state::integrate_verlet(float dt, const particle_terms& terms) {
+    integrate(dt, terms, detail::integrate_kernel::VELOCITY_VERLET);
+}
+
+}
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+struct pipeline_stage {
+
+    enum kind { TRANSFORM4X4, TRANSFORM3X3, PERSPECTIVE_DIVIDE, NORMALIZE, VIEWPORT };
+
+    kind type;
+    float parameters[16];
+
+};
+
+// Elements are copied into a structure-of-arrays block small enough to stay in L1, every stage
+// runs over the block with its constants hoisted, and the block is written out once. float3 chunks
+// other than the last of a block move as four floats per element; the extra float read or written
+// belongs to the next element of the same block, which is stored afterwards.
+struct pipeline_kernel {
+
+    enum { BLOCK = 512 };
+
+    template <class V>
+    static void run(const pipeline_stage* stages, size_t stage_count, const float* input, int input_components, float* output, int output_components, size_t begin, size_t end) {
+        float block[4][BLOCK];
+        for (size_t first = begin; first < end; first += BLOCK) {
+            size_t size = end - first < (size_t)BLOCK ? end - first : (size_t)BLOCK;
+
+            for (size_t j = 0; j < size; j += V::width) {
+                int lanes = size - j < (size_t)V::width ? (int)(size - j) : (int)V::width;
+                V fields[4];
+                if (input_components == 3 && j + V::width < size) load_transposed4(input + (first + j) * 3, 3, fields);
+                else simd::load_interleaved(input + (first + j) * input_components, fields, input_components, lanes);
+                if (input_components == 3) fields[3] = V(1.0f);
+                for (int c = 0; c < 4; c++) fields[c].store(block[c] + j);
+            }
+
+            for (size_t s = 0; s < stage_count; s++) apply<V>(stages[s], block, size);
+
+            for (size_t j = 0; j < size; j += V::width) {
+                int lanes = size - j < (size_t)V::width ? (int)(size - j) : (int)V::width;
+                V fields[4];
+                for (int c = 0; c < 4; c++) fields[c] = V::load(block[c] + j);
+                if (output_components == 3 && j + V::width < size) store_transposed4(fields, output + (first + j) * 3, 3);
+                else simd::store_interleaved(fields, output + (first + j) * output_components, output_components, lanes);
+            }
+        }
+    }
+
+    template <class V>
+    static void apply(const pipeline_stage& stage, float (*block)[BLOCK], size_t size) {
+        const float* p = stage.parameters;
+        switch (stage.type) {
+        case pipeline_stage::TRANSFORM4X4: {
+            V m[16];
+            for (int k = 0; k < 16; k++) m[k] = V(p[k]);
+            for (size_t j = 0; j < size; j += V::width) {
+                V x = V::load(block[0] + j), y = V::load(block[1] + j), z = V::load(block[2] + j), w = V::load(block[3] + j);
+                for (int r = 0; r < 4; r++) fmadd(m[r], x, fmadd(m[4 + r], y, fmadd(m[8 + r], z, m[12 + r] * w))).store(block[r] + j);
+            }
+            break;
+        }
+        case pipeline_stage::TRANSFORM3X3: {
+            V m[9];
+            for (int k = 0; k < 9; k++) m[k] = V(p[k]);
+            for (size_t j = 0; j < size; j += V::width) {
+                V x = V::load(block[0] + j), y = V::load(block[1] + j), z = V::load(block[2] + j);
+                for (int r = 0; r < 3; r++) fmadd(m[r], x, fmadd(m[3 + r], y, m[6 + r] * z)).store(block[r] + j);
+            }
+            break;
+        }
+        case pipeline_stage::PERSPECTIVE_DIVIDE:
+            for (size_t j = 0; j < size; j += V::width) {
+                V inverse_w = V(1.0f) / V::load(block[3] + j);
+                for (int c = 0; c < 3; c++) (V::load(block[c] + j) * inverse_w).store(block[c] + j);
+                inverse_w.store(block[3] + j);
+            }
+            break;
+        case pipeline_stage::NORMALIZE:
+            for (size_t j = 0; j < size; j += V::width) {
+                V x = V::load(block[0] + j), y = V::load(block[1] + j), z = V::load(block[2] + j);
+                V inverse_length = rsqrt(fmadd(x, x, fmadd(y, y, z * z)));
+                (x * inverse_length).store(block[0] + j);
+                (y * inverse_length).store(block[1] + j);
+                (z * inverse_length).store(block[2] + j);
+            }
+            break;
+        case pipeline_stage::VIEWPORT: {
+            V scale[3] = { V(p[0]), V(p[1]), V(p[2]) }, offset[3] = { V(p[3]), V(p[4]), V(p[5]) };
+            for (size_t j = 0; j < size; j += V::width) {
+                for (int c = 0; c < 3; c++) fmadd(V::load(block[c] + j), scale[c], offset[c]).store(block[c] + j);
+            }
+            break;
+        }
+        }
+    }
+
+};
+
+}
+
+// Chain of vertex operations executed in a single pass: each element is loaded and stored once
+// however many stages there are. Stages run in the order they were added.
+class pipeline {
+
+public:
+
+    NEO_BATCH_FUNC_DECL pipeline() { }
+
+    // Homogeneous transform; float3 inputs are treated as points with w = 1.
+    NEO_BATCH_FUNC_DECL pipeline& transform(const float4x4& matrix);
+    // Linear transform of xyz, leaving w unchanged; e.g. a normal matrix.
+    NEO_BATCH_FUNC_DECL pipeline& transform(const float3x3& matrix);
+    // Divides xyz by w and stores 1 / w in w.
+    NEO_BATCH_FUNC_DECL pipeline& perspective_divide();
+    NEO_BATCH_FUNC_DECL pipeline& normalize();
+    // Maps NDC to window coordinates with y pointing down, matching unproject, and depth from [0, 1]
+    // to [depth_near, depth_far].
+    NEO_BATCH_FUNC_DECL pipeline& viewport(float x, float y, float width, float height, float depth_near = 0.0f, float depth_far = 1.0f);
+
+    NEO_BATCH_FUNC_DECL size_t stage_count() const { return stages.size(); }
+    NEO_BATCH_FUNC_DECL void clear() { stages.clear(); }
+
+    // float3 outputs drop w. Input and output may be the same array.
+    NEO_BATCH_FUNC_DECL void run(const float3* input, float3* output, size_t count) const;
+    NEO_BATCH_FUNC_DECL void run(const float3* input, float4* output, size_t count) const;
+    NEO_BATCH_FUNC_DECL void run(const float4* input, float3* output, size_t count) const;
+    NEO_BATCH_FUNC_DECL void run(const float4* input, float4* output, size_t count) const;
+
+private:
+
+    std::vector<detail::pipeline_stage> stages;
+
+    NEO_BATCH_FUNC_DECL pipeline& add(detail::pipeline_stage::kind type, const float* parameters, int count);
+    NEO_BATCH_FUNC_DECL void execute(const float* input, int input_components, float* output, int output_components, size_t count) const;
+
+};
+
+NEO_BATCH_FUNC_DEF pipeline& pipeline::add(detail::pipeline_stage::kind type, const float* parameters, int count) {
+    detail::pipeline_stage stage = { type, { } };
+    for (int k = 0; k < count; k++) stage.parameters[k] = parameters[k];
+    stages.push_back(stage);
+    return *this;
+}
+
+NEO_BATCH_FUNC_DEF pipeline& pipeline::transform(const float4x4& matrix) {
+    float parameters[16];
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) parameters[c * 4 + r] = matrix[c][r];
+    }
+    return add(detail::pipeline_stage::TRANSFORM4X4, parameters, 16);
+}
+
+NEO_BATCH_FUNC_DEF pipeline& pipeline::transform(const float3x3& matrix) {
+    float parameters[9];
+    for (int c = 0; c < 3; c++) {
+        for (int r = 0; r < 3; r++) parameters[c * 3 + r] = matrix[c][r];
+    }
+    return add(detail::pipeline_stage::TRANSFORM3X3, parameters, 9);
+}
+
+NEO_BATCH_FUNC_DEF pipeline& pipeline::perspective_divide() {
+    return add(detail::pipeline_stage::PERSPECTIVE_DIVIDE, nullptr, 0);
+}
+
+NEO_BATCH_FUNC_DEF pipeline& pipeline::normalize() {
+    return add(detail::pipeline_stage::NORMALIZE, nullptr, 0);
+}
+
+NEO_BATCH_FUNC_DEF pipeline& pipeline::viewport(float x, float y, float width, float height, float depth_near, float depth_far) {
+    float parameters[6] = {
+        0.5f * width, -0.5f * height, depth_far - depth_near,
+        x + 0.5f * width, y + 0.5f * height, depth_near
+    };
+    return add(detail::pipeline_stage::VIEWPORT, parameters, 6);
+}
+
+NEO_BATCH_FUNC_DEF void pipeline::execute(const float* input, int input_components, float* output, int output_components, size_t count) const {
+    const detail::pipeline_stage* first = stages.data();
+    size_t stage_count = stages.size();
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::pipeline_kernel>(first, stage_count, input, input_components, output, output_components, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void pipeline::run(const float3* input, float3* output, size_t count) const {
+    execute(&input[0].x, 3, &output[0].x, 3, count);
+}
+
+NEO_BATCH_FUNC_DEF void pipeline::run(const float3* input, float4* output, size_t count) const {
+    execute(&input[0].x, 3, &output[0].x, 4, count);
+}
+
+NEO_BATCH_FUNC_DEF void pipeline::run(const float4* input, float3* output, size_t count) const {
+    execute(&input[0].x, 4, &output[0].x, 3, count);
+}
+
+NEO_BATCH_FUNC_DEF void pipeline::run(const float4* input, float4* output, size_t count) const {
+    execute(&input[0].x, 4, &output[0].x, 4, count);
+}
+
+}
+
+#endif
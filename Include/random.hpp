@@ -0,0 +1,245 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cmath>
+#include <stdint.h>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+const uint32_t GOLDEN_GAMMA = 0x9E3779B9u;
+
+// Integer hash with low bias by Chris Wellons ("triple32") for uint32_t or integer lanes; every
+// step is a bijection on 32 bits.
+template <class I>
+inline I triple32(I x) {
+    x = x ^ x >> 17;
+    x = x * I((int32_t)0xED5AD4BBu);
+    x = x ^ x >> 11;
+    x = x * I((int32_t)0xAC4C1B51u);
+    x = x ^ x >> 15;
+    x = x * I((int32_t)0x31848BABu);
+    return x ^ x >> 14;
+}
+
+// Value at position index of the stream identified by key. Distinct indices never collide.
+template <class I>
+inline I random_bits(uint32_t key, const I& index) {
+    return triple32(index * I((int32_t)GOLDEN_GAMMA) + I((int32_t)key));
+}
+
+// 24 random bits as a float in [0, 1).
+template <class V>
+inline V random_unit(const typename V::int_type& bits) {
+    return to_float(bits >> 8) * V(1.0f / 16777216.0f);
+}
+
+template <class I>
+inline I lane_indices(size_t first) {
+    uint32_t indices[I::width];
+    for (int l = 0; l < I::width; l++) indices[l] = (uint32_t)(first + l);
+    return I::load(indices);
+}
+
+struct uniform_kernel {
+    template <class V>
+    static void run(uint32_t key, float* values, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            random_unit<V>(random_bits(key, lane_indices<I>(i))).store(values + i, lanes);
+        }
+    }
+};
+
+struct uniform_bits_kernel {
+    template <class V>
+    static void run(uint32_t key, uint32_t* values, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            random_bits(key, lane_indices<I>(i)).store(values + i, lanes);
+        }
+    }
+};
+
+// Draws a point of the unit square per sample, jittered within a columns x rows grid for the first
+// columns * rows samples when stratifying, and maps it to the requested domain. Sample i uses values
+// 2i and 2i + 1 of the stream.
+struct sample_kernel {
+
+    enum domain { SQUARE, DISK, SPHERE, HEMISPHERE, COSINE_HEMISPHERE };
+
+    template <class V>
+    static void run(uint32_t key, domain type, size_t columns, size_t rows, float* samples, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+
+        const float PI = 3.14159265358979f;
+        size_t strata = columns * rows;
+        int components = type == SQUARE || type == DISK ? 2 : 3;
+        V one_below = V(0.99999994f);
+        V lane_offsets = to_float(lane_indices<I>(0));
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            I index = lane_indices<I>(i);
+            V u = random_unit<V>(random_bits(key, index << 1));
+            V v = random_unit<V>(random_bits(key, (index << 1) + I(1)));
+
+            if (i < strata) {
+                size_t column = i % columns, row = i / columns;
+                if (column + V::width <= columns && i + V::width <= strata) {
+                    u = min((V((float)column) + lane_offsets + u) * V(1.0f / columns), one_below);
+                    v = min((V((float)row) + v) * V(1.0f / rows), one_below);
+                } else {
+                    float cell_u[V::width], cell_v[V::width], scale_u[V::width], scale_v[V::width];
+                    for (int l = 0; l < V::width; l++) {
+                        bool stratified = i + l < strata;
+                        cell_u[l] = stratified ? (float)column : 0.0f;
+                        cell_v[l] = stratified ? (float)row : 0.0f;
+                        scale_u[l] = stratified ? 1.0f / columns : 1.0f;
+                        scale_v[l] = stratified ? 1.0f / rows : 1.0f;
+                        if (++column == columns) {
+                            column = 0;
+                            row++;
+                        }
+                    }
+                    u = min((V::load(cell_u) + u) * V::load(scale_u), one_below);
+                    v = min((V::load(cell_v) + v) * V::load(scale_v), one_below);
+                }
+            }
+
+            V fields[3];
+            switch (type) {
+            case SQUARE:
+                fields[0] = u;
+                fields[1] = v;
+                break;
+            case DISK:
+            case COSINE_HEMISPHERE: {
+                // Concentric mapping of Shirley and Chiu, which keeps strata compact.
+                V a = fmadd(u, V(2.0f), V(-1.0f)), b = fmadd(v, V(2.0f), V(-1.0f));
+                V wide = abs(a) > abs(b);
+                V radius = select(wide, a, b);
+                V safe_radius = select(radius == V(0.0f), V(1.0f), radius);
+                V ratio = select(wide, b, a) / safe_radius;
+                V angle = select(wide, ratio * V(0.25f * PI), fnmadd(ratio, V(0.25f * PI), V(0.5f * PI)));
+                V sine, cosine;
+                simd::sincos(angle, sine, cosine);
+                fields[0] = radius * cosine;
+                fields[1] = radius * sine;
+                fields[2] = sqrt(max(fnmadd(fields[0], fields[0], fnmadd(fields[1], fields[1], V(1.0f))), V(0.0f)));
+                break;
+            }
+            case SPHERE:
+            case HEMISPHERE: {
+                V z = type == SPHERE ? fnmadd(u, V(2.0f), V(1.0f)) : u;
+                V radius = sqrt(max(fnmadd(z, z, V(1.0f)), V(0.0f)));
+                V sine, cosine;
+                simd::sincos(v * V(2.0f * PI), sine, cosine);
+                fields[0] = radius * cosine;
+                fields[1] = radius * sine;
+                fields[2] = z;
+                break;
+            }
+            }
+            simd::store_interleaved(fields, samples + i * components, components, lanes);
+        }
+    }
+
+};
+
+}
+
+// Counter-based generator: value n of a batch is a hash of n and a key unique to the seed and the
+// batch, so batches fill in parallel and give the same values for any thread count. Each call
+// consumes one batch. The uniform values are also identical across SIMD backends; the samplers
+// that map them through multiply-adds or sincos may differ between backends in the last bits.
+class random_generator {
+
+public:
+
+    NEO_BATCH_FUNC_DECL explicit random_generator(uint32_t seed = 0): key(detail::triple32<uint32_t>(seed ^ 0x5BD1E995u)), batch(0) { }
+
+    NEO_BATCH_FUNC_DECL void seed(uint32_t seed) { *this = random_generator(seed); }
+
+    // Floats in [0, 1) with 24 random bits, or raw 32 bit values.
+    NEO_BATCH_FUNC_DECL void uniform(float* values, size_t count);
+    NEO_BATCH_FUNC_DECL void uniform(uint32_t* values, size_t count);
+
+    // Stratified batches jitter the first columns * rows samples within a grid as close to square as
+    // the count allows, with columns = floor(sqrt(count)); the remaining samples are independent.
+    // Hemispheres are centered on +z.
+    NEO_BATCH_FUNC_DECL void square(float2* samples, size_t count, bool stratified = false);
+    NEO_BATCH_FUNC_DECL void disk(float2* samples, size_t count, bool stratified = false);
+    NEO_BATCH_FUNC_DECL void sphere(float3* directions, size_t count, bool stratified = false);
+    NEO_BATCH_FUNC_DECL void hemisphere(float3* directions, size_t count, bool stratified = false);
+    NEO_BATCH_FUNC_DECL void cosine_hemisphere(float3* directions, size_t count, bool stratified = false);
+
+private:
+
+    uint32_t key;
+    uint64_t batch;
+
+    NEO_BATCH_FUNC_DECL uint32_t next_key() {
+        uint32_t high = detail::triple32<uint32_t>((uint32_t)(batch >> 32) ^ key);
+        return detail::triple32<uint32_t>((uint32_t)batch++ * detail::GOLDEN_GAMMA + high);
+    }
+
+    NEO_BATCH_FUNC_DECL void sample(detail::sample_kernel::domain type, float* samples, size_t count, bool stratified);
+
+};
+
+NEO_BATCH_FUNC_DEF void random_generator::uniform(float* values, size_t count) {
+    uint32_t stream = next_key();
+    parallel_for(count, 1 << 15, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::uniform_kernel>(stream, values, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void random_generator::uniform(uint32_t* values, size_t count) {
+    uint32_t stream = next_key();
+    parallel_for(count, 1 << 15, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::uniform_bits_kernel>(stream, values, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void random_generator::sample(detail::sample_kernel::domain type, float* samples, size_t count, bool stratified) {
+    uint32_t stream = next_key();
+    size_t columns = 0, rows = 0;
+    if (stratified && count > 0) {
+        columns = (size_t)std::sqrt((double)count);
+        while (columns * columns > count) columns--;
+        while ((columns + 1) * (columns + 1) <= count) columns++;
+        rows = count / columns;
+    }
+    parallel_for(count, 1 << 14, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::sample_kernel>(stream, type, columns, rows, samples, begin, end);
+    });
+}
+
+NEO_BATCH_FUNC_DEF void random_generator::square(float2* samples, size_t count, bool stratified) {
+    sample(detail::sample_kernel::SQUARE, &samples[0].x, count, stratified);
+}
+
+NEO_BATCH_FUNC_DEF void random_generator::disk(float2* samples, size_t count, bool stratified) {
+    sample(detail::sample_kernel::DISK, &samples[0].x, count, stratified);
+}
+
+NEO_BATCH_FUNC_DEF void random_generator::sphere(float3* directions, size_t count, bool stratified) {
+    sample(detail::sample_kernel::SPHERE, &directions[0].x, count, stratified);
+}
+
+NEO_BATCH_FUNC_DEF void random_generator::hemisphere(float3* directions, size_t count, bool stratified) {
+    sample(detail::sample_kernel::HEMISPHERE, &directions[0].x, count, stratified);
+}
+
+NEO_BATCH_FUNC_DEF void random_generator::cosine_hemisphere(float3* directions, size_t count, bool stratified) {
+    sample(detail::sample_kernel::COSINE_HEMISPHERE, &directions[0].x, count, stratified);
+}
+
+}
+
+#endif
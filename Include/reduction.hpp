@@ -0,0 +1,353 @@
+#ifndef REDUCTION_HPP
+#define REDUCTION_HPP
+
+#include <limits>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+const size_t REDUCTION_GRAIN = 1 << 15;
+
+// An array of N-component vectors is read as one flat float stream. With period vectors per step,
+// lane l of the p-th accumulator always holds component (p * width + l) % N.
+template <int N, class V>
+struct flat_layout {
+    enum { period = N == 3 ? 3 : 1, step = period * V::width };
+};
+
+template <int N>
+struct sum_partial {
+    double sum[N];
+};
+
+template <int N>
+struct bounds_partial {
+    float lower[N], upper[N];
+};
+
+// Count, mean and scatter matrix (sum of outer products about the mean) of a range of vectors.
+template <int N>
+struct moments_partial {
+    double count, mean[N], scatter[N][N];
+};
+
+template <int N>
+struct sum_kernel {
+    template <class V>
+    static sum_partial<N> run(const float* data, size_t begin, size_t end) {
+        typedef flat_layout<N, V> layout;
+
+        const float* first = data + begin * N;
+        size_t floats = (end - begin) * N, i = 0;
+
+        V accumulators[layout::period * 2];
+        for (int p = 0; p < layout::period * 2; p++) accumulators[p] = V(0.0f);
+        for (; i + 2 * layout::step <= floats; i += 2 * layout::step) {
+            for (int p = 0; p < layout::period * 2; p++) accumulators[p] = accumulators[p] + V::load(first + i + p * V::width);
+        }
+
+        sum_partial<N> result;
+        for (int c = 0; c < N; c++) result.sum[c] = 0.0;
+        for (int p = 0; p < layout::period * 2; p++) {
+            float lanes[V::width];
+            accumulators[p].store(lanes);
+            for (int l = 0; l < V::width; l++) result.sum[(p * V::width + l) % N] += lanes[l];
+        }
+        for (; i < floats; i++) result.sum[i % N] += first[i];
+        return result;
+    }
+};
+
+template <int N>
+struct bounds_kernel {
+    template <class V>
+    static bounds_partial<N> run(const float* data, size_t begin, size_t end) {
+        typedef flat_layout<N, V> layout;
+
+        const float* first = data + begin * N;
+        size_t floats = (end - begin) * N, i = 0;
+
+        V lower[layout::period], upper[layout::period];
+        for (int p = 0; p < layout::period; p++) {
+            lower[p] = V(std::numeric_limits<float>::infinity());
+            upper[p] = V(-std::numeric_limits<float>::infinity());
+        }
+        for (; i + layout::step <= floats; i += layout::step) {
+            for (int p = 0; p < layout::period; p++) {
+                V v = V::load(first + i + p * V::width);
+                lower[p] = min(lower[p], v);
+                upper[p] = max(upper[p], v);
+            }
+        }
+
+        bounds_partial<N> result;
+        for (int c = 0; c < N; c++) {
+            result.lower[c] = std::numeric_limits<float>::infinity();
+            result.upper[c] = -std::numeric_limits<float>::infinity();
+        }
+        for (int p = 0; p < layout::period; p++) {
+            float lower_lanes[V::width], upper_lanes[V::width];
+            lower[p].store(lower_lanes);
+            upper[p].store(upper_lanes);
+            for (int l = 0; l < V::width; l++) {
+                int c = (p * V::width + l) % N;
+                result.lower[c] = simd::min(result.lower[c], lower_lanes[l]);
+                result.upper[c] = simd::max(result.upper[c], upper_lanes[l]);
+            }
+        }
+        for (; i < floats; i++) {
+            result.lower[i % N] = simd::min(result.lower[i % N], first[i]);
+            result.upper[i % N] = simd::max(result.upper[i % N], first[i]);
+        }
+        return result;
+    }
+};
+
+// Products between components come from loads offset by k floats: lane l of the p-th accumulator
+// for offset k holds the product of components c and c + k, which is discarded when c + k >= N.
+// Values are shifted by the first vector of the range to keep float accumulation well conditioned.
+template <int N>
+struct moments_kernel {
+    template <class V>
+    static moments_partial<N> run(const float* data, size_t begin, size_t end) {
+        typedef flat_layout<N, V> layout;
+
+        const float* first = data + begin * N;
+        size_t floats = (end - begin) * N, i = 0;
+
+        float pattern[layout::step + N];
+        for (int j = 0; j < layout::step + N; j++) pattern[j] = first[j % N];
+
+        V sums[layout::period], products[layout::period][N];
+        for (int p = 0; p < layout::period; p++) {
+            sums[p] = V(0.0f);
+            for (int k = 0; k < N; k++) products[p][k] = V(0.0f);
+        }
+        for (; i + layout::step + N <= floats; i += layout::step) {
+            for (int p = 0; p < layout::period; p++) {
+                V d = V::load(first + i + p * V::width) - V::load(pattern + p * V::width);
+                sums[p] = sums[p] + d;
+                products[p][0] = fmadd(d, d, products[p][0]);
+                for (int k = 1; k < N; k++) {
+                    V e = V::load(first + i + p * V::width + k) - V::load(pattern + p * V::width + k);
+                    products[p][k] = fmadd(d, e, products[p][k]);
+                }
+            }
+        }
+
+        double sum[N], product[N][N];
+        for (int c = 0; c < N; c++) {
+            sum[c] = 0.0;
+            for (int k = 0; k < N; k++) product[c][k] = 0.0;
+        }
+        for (int p = 0; p < layout::period; p++) {
+            float lanes[V::width];
+            sums[p].store(lanes);
+            for (int l = 0; l < V::width; l++) sum[(p * V::width + l) % N] += lanes[l];
+            for (int k = 0; k < N; k++) {
+                products[p][k].store(lanes);
+                for (int l = 0; l < V::width; l++) {
+                    int c = (p * V::width + l) % N;
+                    if (c + k < N) product[c][c + k] += lanes[l];
+                }
+            }
+        }
+        for (; i < floats; i += N) {
+            float d[N];
+            for (int c = 0; c < N; c++) {
+                d[c] = first[i + c] - first[c];
+                sum[c] += d[c];
+            }
+            for (int r = 0; r < N; r++) {
+                for (int c = r; c < N; c++) product[r][c] += d[r] * d[c];
+            }
+        }
+
+        moments_partial<N> result;
+        result.count = (double)(end - begin);
+        for (int c = 0; c < N; c++) result.mean[c] = first[c] + sum[c] / result.count;
+        for (int r = 0; r < N; r++) {
+            for (int c = r; c < N; c++) {
+                result.scatter[r][c] = result.scatter[c][r] = product[r][c] - sum[r] * sum[c] / result.count;
+            }
+        }
+        return result;
+    }
+};
+
+template <int N>
+inline sum_partial<N> sum(const float* data, size_t count) {
+    sum_partial<N> identity;
+    for (int c = 0; c < N; c++) identity.sum[c] = 0.0;
+    return parallel_reduce(count, REDUCTION_GRAIN, identity,
+        [data](size_t begin, size_t end) { return simd::dispatch<sum_kernel<N> >(data, begin, end); },
+        [](const sum_partial<N>& lhs, const sum_partial<N>& rhs) {
+            sum_partial<N> result;
+            for (int c = 0; c < N; c++) result.sum[c] = lhs.sum[c] + rhs.sum[c];
+            return result;
+        });
+}
+
+template <int N>
+inline bounds_partial<N> bounds(const float* data, size_t count) {
+    bounds_partial<N> identity;
+    for (int c = 0; c < N; c++) {
+        identity.lower[c] = std::numeric_limits<float>::infinity();
+        identity.upper[c] = -std::numeric_limits<float>::infinity();
+    }
+    return parallel_reduce(count, REDUCTION_GRAIN, identity,
+        [data](size_t begin, size_t end) { return simd::dispatch<bounds_kernel<N> >(data, begin, end); },
+        [](const bounds_partial<N>& lhs, const bounds_partial<N>& rhs) {
+            bounds_partial<N> result;
+            for (int c = 0; c < N; c++) {
+                result.lower[c] = simd::min(lhs.lower[c], rhs.lower[c]);
+                result.upper[c] = simd::max(lhs.upper[c], rhs.upper[c]);
+            }
+            return result;
+        });
+}
+
+// Partials are merged with the pairwise update of Chan, Golub and LeVeque.
+template <int N>
+inline moments_partial<N> moments(const float* data, size_t count) {
+    moments_partial<N> identity;
+    identity.count = 0.0;
+    for (int r = 0; r < N; r++) {
+        identity.mean[r] = 0.0;
+        for (int c = 0; c < N; c++) identity.scatter[r][c] = 0.0;
+    }
+    return parallel_reduce(count, REDUCTION_GRAIN, identity,
+        [data](size_t begin, size_t end) { return simd::dispatch<moments_kernel<N> >(data, begin, end); },
+        [](const moments_partial<N>& lhs, const moments_partial<N>& rhs) {
+            moments_partial<N> result;
+            result.count = lhs.count + rhs.count;
+            double weight = lhs.count * rhs.count / result.count;
+            double delta[N];
+            for (int r = 0; r < N; r++) {
+                delta[r] = rhs.mean[r] - lhs.mean[r];
+                result.mean[r] = lhs.mean[r] + delta[r] * rhs.count / result.count;
+            }
+            for (int r = 0; r < N; r++) {
+                for (int c = 0; c < N; c++) result.scatter[r][c] = lhs.scatter[r][c] + rhs.scatter[r][c] + delta[r] * delta[c] * weight;
+            }
+            return result;
+        });
+}
+
+}
+
+NEO_BATCH_FUNC_DEF float2 sum(const float2* vectors, size_t count) {
+    detail::sum_partial<2> result = detail::sum<2>((const float*)vectors, count);
+    return float2((float)result.sum[0], (float)result.sum[1]);
+}
+
+NEO_BATCH_FUNC_DEF float3 sum(const float3* vectors, size_t count) {
+    detail::sum_partial<3> result = detail::sum<3>((const float*)vectors, count);
+    return float3((float)result.sum[0], (float)result.sum[1], (float)result.sum[2]);
+}
+
+NEO_BATCH_FUNC_DEF float4 sum(const float4* vectors, size_t count) {
+    detail::sum_partial<4> result = detail::sum<4>((const float*)vectors, count);
+    return float4((float)result.sum[0], (float)result.sum[1], (float)result.sum[2], (float)result.sum[3]);
+}
+
+NEO_BATCH_FUNC_DEF float2 min(const float2* vectors, size_t count) {
+    float2 lower, upper;
+    bounds(vectors, count, lower, upper);
+    return lower;
+}
+
+NEO_BATCH_FUNC_DEF float3 min(const float3* vectors, size_t count) {
+    float3 lower, upper;
+    bounds(vectors, count, lower, upper);
+    return lower;
+}
+
+NEO_BATCH_FUNC_DEF float4 min(const float4* vectors, size_t count) {
+    float4 lower, upper;
+    bounds(vectors, count, lower, upper);
+    return lower;
+}
+
+NEO_BATCH_FUNC_DEF float2 max(const float2* vectors, size_t count) {
+    float2 lower, upper;
+    bounds(vectors, count, lower, upper);
+    return upper;
+}
+
+NEO_BATCH_FUNC_DEF float3 max(const float3* vectors, size_t count) {
+    float3 lower, upper;
+    bounds(vectors, count, lower, upper);
+    return upper;
+}
+
+NEO_BATCH_FUNC_DEF float4 max(const float4* vectors, size_t count) {
+    float4 lower, upper;
+    bounds(vectors, count, lower, upper);
+    return upper;
+}
+
+NEO_BATCH_FUNC_DEF void bounds(const float2* vectors, size_t count, float2& lower, float2& upper) {
+    detail::bounds_partial<2> result = detail::bounds<2>((const float*)vectors, count);
+    lower = float2(result.lower[0], result.lower[1]);
+    upper = float2(result.upper[0], result.upper[1]);
+}
+
+NEO_BATCH_FUNC_DEF void bounds(const float3* vectors, size_t count, float3& lower, float3& upper) {
+    detail::bounds_partial<3> result = detail::bounds<3>((const float*)vectors, count);
+    lower = float3(result.lower[0], result.lower[1], result.lower[2]);
+    upper = float3(result.upper[0], result.upper[1], result.upper[2]);
+}
+
+NEO_BATCH_FUNC_DEF void bounds(const float4* vectors, size_t count, float4& lower, float4& upper) {
+    detail::bounds_partial<4> result = detail::bounds<4>((const float*)vectors, count);
+    lower = float4(result.lower[0], result.lower[1], result.lower[2], result.lower[3]);
+    upper = float4(result.upper[0], result.upper[1], result.upper[2], result.upper[3]);
+}
+
+NEO_BATCH_FUNC_DEF float2 mean(const float2* vectors, size_t count) {
+    return count > 0 ? sum(vectors, count) / (float)count : float2();
+}
+
+NEO_BATCH_FUNC_DEF float3 mean(const float3* vectors, size_t count) {
+    return count > 0 ? sum(vectors, count) / (float)count : float3();
+}
+
+NEO_BATCH_FUNC_DEF float4 mean(const float4* vectors, size_t count) {
+    return count > 0 ? sum(vectors, count) / (float)count : float4();
+}
+
+NEO_BATCH_FUNC_DEF float2x2 covariance(const float2* vectors, size_t count) {
+    detail::moments_partial<2> m = detail::moments<2>((const float*)vectors, count);
+    double scale = count > 0 ? 1.0 / m.count : 0.0;
+    return float2x2(
+        (float)(m.scatter[0][0] * scale), (float)(m.scatter[1][0] * scale),
+        (float)(m.scatter[0][1] * scale), (float)(m.scatter[1][1] * scale)
+    );
+}
+
+NEO_BATCH_FUNC_DEF float3x3 covariance(const float3* vectors, size_t count) {
+    detail::moments_partial<3> m = detail::moments<3>((const float*)vectors, count);
+    double scale = count > 0 ? 1.0 / m.count : 0.0;
+    return float3x3(
+        (float)(m.scatter[0][0] * scale), (float)(m.scatter[1][0] * scale), (float)(m.scatter[2][0] * scale),
+        (float)(m.scatter[0][1] * scale), (float)(m.scatter[1][1] * scale), (float)(m.scatter[2][1] * scale),
+        (float)(m.scatter[0][2] * scale), (float)(m.scatter[1][2] * scale), (float)(m.scatter[2][2] * scale)
+    );
+}
+
+NEO_BATCH_FUNC_DEF float4x4 covariance(const float4* vectors, size_t count) {
+    detail::moments_partial<4> m = detail::moments<4>((const float*)vectors, count);
+    double scale = count > 0 ? 1.0 / m.count : 0.0;
+    float4 columns[4];
+    for (int c = 0; c < 4; c++) {
+        columns[c] = float4((float)(m.scatter[0][c] * scale), (float)(m.scatter[1][c] * scale), (float)(m.scatter[2][c] * scale), (float)(m.scatter[3][c] * scale));
+    }
+    return float4x4(columns[0], columns[1], columns[2], columns[3]);
+}
+
+}
+
+#endif
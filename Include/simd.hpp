@@ -0,0 +1,770 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+// SIMD support
+#define NEO_SIMD_SCALAR 0
+#define NEO_SIMD_SSE2 1
+#define NEO_SIMD_AVX2 2
+
+#ifndef NEO_SIMD
+#if defined(__CUDACC__)
+#define NEO_SIMD NEO_SIMD_SCALAR
+#elif defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define NEO_SIMD NEO_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NEO_SIMD NEO_SIMD_SSE2
+#else
+#define NEO_SIMD NEO_SIMD_SCALAR
+#endif
+#endif
+
+#if NEO_SIMD >= NEO_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if NEO_SIMD >= NEO_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+// Runtime dispatch: with NEO_DISPATCH, an SSE2 build also compiles the AVX2 backend and batch
+// kernels pick it when the processor supports it. AVX2 functions then carry a target attribute and
+// are flattened into per-kernel entry points, which needs inlining to be enabled.
+#ifndef NEO_DISPATCH
+#define NEO_DISPATCH 0
+#endif
+
+#if NEO_DISPATCH && NEO_SIMD == NEO_SIMD_SSE2 && !defined(__CUDACC__) && (defined(_MSC_VER) || ((defined(__GNUC__) || defined(__clang__)) && !defined(__NO_INLINE__)))
+#define NEO_DISPATCH_AVX2 1
+#else
+#define NEO_DISPATCH_AVX2 0
+#endif
+
+#if NEO_DISPATCH_AVX2
+#include <cstdlib>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define NEO_AVX2_TARGET
+#define NEO_FLATTEN
+#else
+#include <cpuid.h>
+#define NEO_AVX2_TARGET __attribute__((target("avx2,fma")))
+#define NEO_FLATTEN __attribute__((flatten))
+#endif
+#endif
+
+// BMI2 bit deposit and extract (present on every AVX2 processor)
+#ifndef NEO_BMI2
+#if !defined(__CUDACC__) && (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__)))
+#define NEO_BMI2 1
+#else
+#define NEO_BMI2 0
+#endif
+#endif
+
+#if NEO_BMI2
+#include <immintrin.h>
+#endif
+
+// Function qualifiers
+#define NEO_SCALAR_FUNC_DEF inline
+#define NEO_SSE2_FUNC_DEF inline
+#if NEO_DISPATCH_AVX2
+#define NEO_AVX2_FUNC_DEF inline NEO_AVX2_TARGET
+#else
+#define NEO_AVX2_FUNC_DEF inline
+#endif
+
+namespace neo {
+namespace simd {
+
+// Portable fallback, four lanes wide so that it vectorizes where the compiler can.
+namespace scalar {
+
+struct intv;
+
+struct floatv {
+
+    enum { width = 4 };
+    typedef simd::scalar::intv int_type;
+
+    float lanes[4];
+
+    NEO_SCALAR_FUNC_DEF floatv() { }
+    NEO_SCALAR_FUNC_DEF floatv(float scalar) { for (int i = 0; i < 4; i++) lanes[i] = scalar; }
+
+    static NEO_SCALAR_FUNC_DEF floatv load(const float* pointer) { floatv result; for (int i = 0; i < 4; i++) result.lanes[i] = pointer[i]; return result; }
+    static NEO_SCALAR_FUNC_DEF floatv load(const float* pointer, int count) { floatv result(0.0f); for (int i = 0; i < count; i++) result.lanes[i] = pointer[i]; return result; }
+    static NEO_SCALAR_FUNC_DEF floatv load_strided(const float* pointer, size_t stride, int count) { floatv result(0.0f); for (int i = 0; i < count; i++) result.lanes[i] = pointer[i * stride]; return result; }
+    NEO_SCALAR_FUNC_DEF void store(float* pointer) const { for (int i = 0; i < 4; i++) pointer[i] = lanes[i]; }
+    NEO_SCALAR_FUNC_DEF void store(float* pointer, int count) const { for (int i = 0; i < count; i++) pointer[i] = lanes[i]; }
+
+    NEO_SCALAR_FUNC_DEF float operator[](int index) const { return lanes[index]; }
+
+};
+
+struct intv {
+
+    enum { width = 4 };
+
+    uint32_t lanes[4];
+
+    NEO_SCALAR_FUNC_DEF intv() { }
+    NEO_SCALAR_FUNC_DEF intv(int32_t scalar) { for (int i = 0; i < 4; i++) lanes[i] = (uint32_t)scalar; }
+
+    static NEO_SCALAR_FUNC_DEF intv load(const uint32_t* pointer) { intv result; for (int i = 0; i < 4; i++) result.lanes[i] = pointer[i]; return result; }
+    static NEO_SCALAR_FUNC_DEF intv load(const uint32_t* pointer, int count) { intv result(0); for (int i = 0; i < count; i++) result.lanes[i] = pointer[i]; return result; }
+    NEO_SCALAR_FUNC_DEF void store(uint32_t* pointer) const { for (int i = 0; i < 4; i++) pointer[i] = lanes[i]; }
+    NEO_SCALAR_FUNC_DEF void store(uint32_t* pointer, int count) const { for (int i = 0; i < count; i++) pointer[i] = lanes[i]; }
+
+    NEO_SCALAR_FUNC_DEF uint32_t operator[](int index) const { return lanes[index]; }
+
+};
+
+NEO_SCALAR_FUNC_DEF uint32_t bits(float scalar) { uint32_t result; std::memcpy(&result, &scalar, 4); return result; }
+NEO_SCALAR_FUNC_DEF float from_bits(uint32_t scalar) { float result; std::memcpy(&result, &scalar, 4); return result; }
+NEO_SCALAR_FUNC_DEF float mask(bool condition) { return from_bits(condition ? 0xFFFFFFFFu : 0u); }
+
+#define NEO_SCALAR_FLOAT_LANES(expression) floatv result; for (int i = 0; i < 4; i++) result.lanes[i] = (expression); return result
+#define NEO_SCALAR_INT_LANES(expression) intv result; for (int i = 0; i < 4; i++) result.lanes[i] = (expression); return result
+
+NEO_SCALAR_FUNC_DEF floatv operator-(const floatv& v) { NEO_SCALAR_FLOAT_LANES(-v.lanes[i]); }
+NEO_SCALAR_FUNC_DEF floatv operator+(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(lhs.lanes[i] + rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF floatv operator-(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(lhs.lanes[i] - rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF floatv operator*(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(lhs.lanes[i] * rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF floatv operator/(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(lhs.lanes[i] / rhs.lanes[i]); }
+
+NEO_SCALAR_FUNC_DEF floatv operator<(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(mask(lhs.lanes[i] < rhs.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv operator<=(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(mask(lhs.lanes[i] <= rhs.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv operator>(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(mask(lhs.lanes[i] > rhs.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv operator>=(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(mask(lhs.lanes[i] >= rhs.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv operator==(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(mask(lhs.lanes[i] == rhs.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv operator!=(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(mask(lhs.lanes[i] != rhs.lanes[i])); }
+
+NEO_SCALAR_FUNC_DEF floatv operator&(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(from_bits(bits(lhs.lanes[i]) & bits(rhs.lanes[i]))); }
+NEO_SCALAR_FUNC_DEF floatv operator|(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(from_bits(bits(lhs.lanes[i]) | bits(rhs.lanes[i]))); }
+NEO_SCALAR_FUNC_DEF floatv operator^(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(from_bits(bits(lhs.lanes[i]) ^ bits(rhs.lanes[i]))); }
+NEO_SCALAR_FUNC_DEF floatv andnot(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(from_bits(~bits(lhs.lanes[i]) & bits(rhs.lanes[i]))); }
+
+NEO_SCALAR_FUNC_DEF floatv fmadd(const floatv& a, const floatv& b, const floatv& c) { NEO_SCALAR_FLOAT_LANES(a.lanes[i] * b.lanes[i] + c.lanes[i]); }
+NEO_SCALAR_FUNC_DEF floatv fnmadd(const floatv& a, const floatv& b, const floatv& c) { NEO_SCALAR_FLOAT_LANES(c.lanes[i] - a.lanes[i] * b.lanes[i]); }
+NEO_SCALAR_FUNC_DEF floatv min(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(lhs.lanes[i] < rhs.lanes[i] ? lhs.lanes[i] : rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF floatv max(const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(lhs.lanes[i] > rhs.lanes[i] ? lhs.lanes[i] : rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF floatv abs(const floatv& v) { NEO_SCALAR_FLOAT_LANES(fabsf(v.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv sqrt(const floatv& v) { NEO_SCALAR_FLOAT_LANES(sqrtf(v.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv rsqrt(const floatv& v) { NEO_SCALAR_FLOAT_LANES(1.0f / sqrtf(v.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv floor(const floatv& v) { NEO_SCALAR_FLOAT_LANES(floorf(v.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv select(const floatv& mask, const floatv& lhs, const floatv& rhs) { NEO_SCALAR_FLOAT_LANES(bits(mask.lanes[i]) >> 31 ? lhs.lanes[i] : rhs.lanes[i]); }
+
+NEO_SCALAR_FUNC_DEF int mask_bits(const floatv& mask) {
+    int result = 0;
+    for (int i = 0; i < 4; i++) result |= (int)(bits(mask.lanes[i]) >> 31) << i;
+    return result;
+}
+
+NEO_SCALAR_FUNC_DEF bool any(const floatv& mask) { return mask_bits(mask) != 0; }
+NEO_SCALAR_FUNC_DEF bool all(const floatv& mask) { return mask_bits(mask) == 0xF; }
+
+NEO_SCALAR_FUNC_DEF float reduce_add(const floatv& v) { return (v.lanes[0] + v.lanes[1]) + (v.lanes[2] + v.lanes[3]); }
+NEO_SCALAR_FUNC_DEF float reduce_min(const floatv& v) { return fminf(fminf(v.lanes[0], v.lanes[1]), fminf(v.lanes[2], v.lanes[3])); }
+NEO_SCALAR_FUNC_DEF float reduce_max(const floatv& v) { return fmaxf(fmaxf(v.lanes[0], v.lanes[1]), fmaxf(v.lanes[2], v.lanes[3])); }
+
+NEO_SCALAR_FUNC_DEF intv operator+(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES(lhs.lanes[i] + rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF intv operator-(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES(lhs.lanes[i] - rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF intv operator*(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES(lhs.lanes[i] * rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF intv operator&(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES(lhs.lanes[i] & rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF intv operator|(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES(lhs.lanes[i] | rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF intv operator^(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES(lhs.lanes[i] ^ rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF intv andnot(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES(~lhs.lanes[i] & rhs.lanes[i]); }
+NEO_SCALAR_FUNC_DEF intv operator<<(const intv& v, int count) { NEO_SCALAR_INT_LANES(v.lanes[i] << count); }
+NEO_SCALAR_FUNC_DEF intv operator>>(const intv& v, int count) { NEO_SCALAR_INT_LANES(v.lanes[i] >> count); }
+
+NEO_SCALAR_FUNC_DEF intv operator==(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES(lhs.lanes[i] == rhs.lanes[i] ? 0xFFFFFFFFu : 0u); }
+NEO_SCALAR_FUNC_DEF intv operator<(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES((int32_t)lhs.lanes[i] < (int32_t)rhs.lanes[i] ? 0xFFFFFFFFu : 0u); }
+NEO_SCALAR_FUNC_DEF intv operator>(const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES((int32_t)lhs.lanes[i] > (int32_t)rhs.lanes[i] ? 0xFFFFFFFFu : 0u); }
+NEO_SCALAR_FUNC_DEF intv select(const intv& mask, const intv& lhs, const intv& rhs) { NEO_SCALAR_INT_LANES(mask.lanes[i] >> 31 ? lhs.lanes[i] : rhs.lanes[i]); }
+
+NEO_SCALAR_FUNC_DEF intv to_int(const floatv& v) { NEO_SCALAR_INT_LANES((uint32_t)(int32_t)v.lanes[i]); }
+NEO_SCALAR_FUNC_DEF intv round_to_int(const floatv& v) { NEO_SCALAR_INT_LANES((uint32_t)(int32_t)nearbyintf(v.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv to_float(const intv& v) { NEO_SCALAR_FLOAT_LANES((float)(int32_t)v.lanes[i]); }
+NEO_SCALAR_FUNC_DEF intv as_int(const floatv& v) { NEO_SCALAR_INT_LANES(bits(v.lanes[i])); }
+NEO_SCALAR_FUNC_DEF floatv as_float(const intv& v) { NEO_SCALAR_FLOAT_LANES(from_bits(v.lanes[i])); }
+
+template <int X, int Y, int Z, int W>
+NEO_SCALAR_FUNC_DEF floatv shuffle(const floatv& v) {
+    floatv result;
+    result.lanes[0] = v.lanes[X];
+    result.lanes[1] = v.lanes[Y];
+    result.lanes[2] = v.lanes[Z];
+    result.lanes[3] = v.lanes[W];
+    return result;
+}
+
+// Loads four floats at pointer + lane * stride for every lane, as four registers of one field each.
+NEO_SCALAR_FUNC_DEF void load_transposed4(const float* pointer, size_t stride, floatv* fields) {
+    for (int l = 0; l < 4; l++) {
+        for (int f = 0; f < 4; f++) fields[f].lanes[l] = pointer[l * stride + f];
+    }
+}
+
+NEO_SCALAR_FUNC_DEF void store_transposed4(const floatv* fields, float* pointer, size_t stride) {
+    for (int l = 0; l < 4; l++) {
+        for (int f = 0; f < 4; f++) pointer[l * stride + f] = fields[f].lanes[l];
+    }
+}
+
+#undef NEO_SCALAR_FLOAT_LANES
+#undef NEO_SCALAR_INT_LANES
+
+}
+
+#if NEO_SIMD >= NEO_SIMD_SSE2
+
+namespace sse2 {
+
+struct intv;
+
+struct floatv {
+
+    enum { width = 4 };
+    typedef simd::sse2::intv int_type;
+
+    __m128 v;
+
+    NEO_SSE2_FUNC_DEF floatv() { }
+    NEO_SSE2_FUNC_DEF floatv(float scalar): v(_mm_set1_ps(scalar)) { }
+    NEO_SSE2_FUNC_DEF floatv(__m128 v): v(v) { }
+
+    static NEO_SSE2_FUNC_DEF floatv load(const float* pointer) { return _mm_loadu_ps(pointer); }
+    static NEO_SSE2_FUNC_DEF floatv load(const float* pointer, int count) {
+        float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < count; i++) lanes[i] = pointer[i];
+        return _mm_loadu_ps(lanes);
+    }
+    static NEO_SSE2_FUNC_DEF floatv load_strided(const float* pointer, size_t stride, int count) {
+        if (count == 4) return _mm_setr_ps(pointer[0], pointer[stride], pointer[2 * stride], pointer[3 * stride]);
+        return _mm_setr_ps(count > 0 ? pointer[0] : 0.0f, count > 1 ? pointer[stride] : 0.0f, count > 2 ? pointer[2 * stride] : 0.0f, 0.0f);
+    }
+    NEO_SSE2_FUNC_DEF void store(float* pointer) const { _mm_storeu_ps(pointer, v); }
+    NEO_SSE2_FUNC_DEF void store(float* pointer, int count) const {
+        float lanes[4];
+        _mm_storeu_ps(lanes, v);
+        for (int i = 0; i < count; i++) pointer[i] = lanes[i];
+    }
+
+    NEO_SSE2_FUNC_DEF float operator[](int index) const { float lanes[4]; _mm_storeu_ps(lanes, v); return lanes[index]; }
+
+};
+
+struct intv {
+
+    enum { width = 4 };
+
+    __m128i v;
+
+    NEO_SSE2_FUNC_DEF intv() { }
+    NEO_SSE2_FUNC_DEF intv(int32_t scalar): v(_mm_set1_epi32(scalar)) { }
+    NEO_SSE2_FUNC_DEF intv(__m128i v): v(v) { }
+
+    static NEO_SSE2_FUNC_DEF intv load(const uint32_t* pointer) { return _mm_loadu_si128((const __m128i*)pointer); }
+    static NEO_SSE2_FUNC_DEF intv load(const uint32_t* pointer, int count) {
+        uint32_t lanes[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < count; i++) lanes[i] = pointer[i];
+        return _mm_loadu_si128((const __m128i*)lanes);
+    }
+    NEO_SSE2_FUNC_DEF void store(uint32_t* pointer) const { _mm_storeu_si128((__m128i*)pointer, v); }
+    NEO_SSE2_FUNC_DEF void store(uint32_t* pointer, int count) const {
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, v);
+        for (int i = 0; i < count; i++) pointer[i] = lanes[i];
+    }
+
+    NEO_SSE2_FUNC_DEF uint32_t operator[](int index) const { uint32_t lanes[4]; _mm_storeu_si128((__m128i*)lanes, v); return lanes[index]; }
+
+};
+
+NEO_SSE2_FUNC_DEF floatv operator-(const floatv& v) { return _mm_xor_ps(v.v, _mm_set1_ps(-0.0f)); }
+NEO_SSE2_FUNC_DEF floatv operator+(const floatv& lhs, const floatv& rhs) { return _mm_add_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator-(const floatv& lhs, const floatv& rhs) { return _mm_sub_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator*(const floatv& lhs, const floatv& rhs) { return _mm_mul_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator/(const floatv& lhs, const floatv& rhs) { return _mm_div_ps(lhs.v, rhs.v); }
+
+NEO_SSE2_FUNC_DEF floatv operator<(const floatv& lhs, const floatv& rhs) { return _mm_cmplt_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator<=(const floatv& lhs, const floatv& rhs) { return _mm_cmple_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator>(const floatv& lhs, const floatv& rhs) { return _mm_cmpgt_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator>=(const floatv& lhs, const floatv& rhs) { return _mm_cmpge_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator==(const floatv& lhs, const floatv& rhs) { return _mm_cmpeq_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator!=(const floatv& lhs, const floatv& rhs) { return _mm_cmpneq_ps(lhs.v, rhs.v); }
+
+NEO_SSE2_FUNC_DEF floatv operator&(const floatv& lhs, const floatv& rhs) { return _mm_and_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator|(const floatv& lhs, const floatv& rhs) { return _mm_or_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv operator^(const floatv& lhs, const floatv& rhs) { return _mm_xor_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv andnot(const floatv& lhs, const floatv& rhs) { return _mm_andnot_ps(lhs.v, rhs.v); }
+
+NEO_SSE2_FUNC_DEF floatv fmadd(const floatv& a, const floatv& b, const floatv& c) { return _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v); }
+NEO_SSE2_FUNC_DEF floatv fnmadd(const floatv& a, const floatv& b, const floatv& c) { return _mm_sub_ps(c.v, _mm_mul_ps(a.v, b.v)); }
+NEO_SSE2_FUNC_DEF floatv min(const floatv& lhs, const floatv& rhs) { return _mm_min_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv max(const floatv& lhs, const floatv& rhs) { return _mm_max_ps(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF floatv abs(const floatv& v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v.v); }
+NEO_SSE2_FUNC_DEF floatv sqrt(const floatv& v) { return _mm_sqrt_ps(v.v); }
+
+NEO_SSE2_FUNC_DEF floatv rsqrt(const floatv& v) {
+    __m128 estimate = _mm_rsqrt_ps(v.v);
+    __m128 half_v_estimate = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), v.v), estimate);
+    return _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half_v_estimate, estimate)));
+}
+
+NEO_SSE2_FUNC_DEF floatv floor(const floatv& v) {
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(v.v));
+    __m128 result = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, v.v), _mm_set1_ps(1.0f)));
+    __m128 integral = _mm_cmpge_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), v.v), _mm_set1_ps(8388608.0f));
+    return _mm_or_ps(_mm_and_ps(integral, v.v), _mm_andnot_ps(integral, result));
+}
+
+NEO_SSE2_FUNC_DEF floatv select(const floatv& mask, const floatv& lhs, const floatv& rhs) {
+    return _mm_or_ps(_mm_and_ps(mask.v, lhs.v), _mm_andnot_ps(mask.v, rhs.v));
+}
+
+NEO_SSE2_FUNC_DEF int mask_bits(const floatv& mask) { return _mm_movemask_ps(mask.v); }
+NEO_SSE2_FUNC_DEF bool any(const floatv& mask) { return _mm_movemask_ps(mask.v) != 0; }
+NEO_SSE2_FUNC_DEF bool all(const floatv& mask) { return _mm_movemask_ps(mask.v) == 0xF; }
+
+NEO_SSE2_FUNC_DEF float reduce_add(const floatv& v) {
+    __m128 pairs = _mm_add_ps(v.v, _mm_movehl_ps(v.v, v.v));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+NEO_SSE2_FUNC_DEF float reduce_min(const floatv& v) {
+    __m128 pairs = _mm_min_ps(v.v, _mm_movehl_ps(v.v, v.v));
+    return _mm_cvtss_f32(_mm_min_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+NEO_SSE2_FUNC_DEF float reduce_max(const floatv& v) {
+    __m128 pairs = _mm_max_ps(v.v, _mm_movehl_ps(v.v, v.v));
+    return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+NEO_SSE2_FUNC_DEF intv operator+(const intv& lhs, const intv& rhs) { return _mm_add_epi32(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF intv operator-(const intv& lhs, const intv& rhs) { return _mm_sub_epi32(lhs.v, rhs.v); }
+
+NEO_SSE2_FUNC_DEF intv operator*(const intv& lhs, const intv& rhs) {
+    __m128i even = _mm_mul_epu32(lhs.v, rhs.v);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(lhs.v, 32), _mm_srli_epi64(rhs.v, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+NEO_SSE2_FUNC_DEF intv operator&(const intv& lhs, const intv& rhs) { return _mm_and_si128(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF intv operator|(const intv& lhs, const intv& rhs) { return _mm_or_si128(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF intv operator^(const intv& lhs, const intv& rhs) { return _mm_xor_si128(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF intv andnot(const intv& lhs, const intv& rhs) { return _mm_andnot_si128(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF intv operator<<(const intv& v, int count) { return _mm_sll_epi32(v.v, _mm_cvtsi32_si128(count)); }
+NEO_SSE2_FUNC_DEF intv operator>>(const intv& v, int count) { return _mm_srl_epi32(v.v, _mm_cvtsi32_si128(count)); }
+
+NEO_SSE2_FUNC_DEF intv operator==(const intv& lhs, const intv& rhs) { return _mm_cmpeq_epi32(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF intv operator<(const intv& lhs, const intv& rhs) { return _mm_cmplt_epi32(lhs.v, rhs.v); }
+NEO_SSE2_FUNC_DEF intv operator>(const intv& lhs, const intv& rhs) { return _mm_cmpgt_epi32(lhs.v, rhs.v); }
+
+NEO_SSE2_FUNC_DEF intv select(const intv& mask, const intv& lhs, const intv& rhs) {
+    return _mm_or_si128(_mm_and_si128(mask.v, lhs.v), _mm_andnot_si128(mask.v, rhs.v));
+}
+
+NEO_SSE2_FUNC_DEF intv to_int(const floatv& v) { return _mm_cvttps_epi32(v.v); }
+NEO_SSE2_FUNC_DEF intv round_to_int(const floatv& v) { return _mm_cvtps_epi32(v.v); }
+NEO_SSE2_FUNC_DEF floatv to_float(const intv& v) { return _mm_cvtepi32_ps(v.v); }
+NEO_SSE2_FUNC_DEF intv as_int(const floatv& v) { return _mm_castps_si128(v.v); }
+NEO_SSE2_FUNC_DEF floatv as_float(const intv& v) { return _mm_castsi128_ps(v.v); }
+
+template <int X, int Y, int Z, int W>
+NEO_SSE2_FUNC_DEF floatv shuffle(const floatv& v) { return _mm_shuffle_ps(v.v, v.v, _MM_SHUFFLE(W, Z, Y, X)); }
+
+NEO_SSE2_FUNC_DEF void transpose4(floatv* rows) {
+    __m128 t0 = _mm_unpacklo_ps(rows[0].v, rows[1].v);
+    __m128 t1 = _mm_unpacklo_ps(rows[2].v, rows[3].v);
+    __m128 t2 = _mm_unpackhi_ps(rows[0].v, rows[1].v);
+    __m128 t3 = _mm_unpackhi_ps(rows[2].v, rows[3].v);
+    rows[0] = _mm_movelh_ps(t0, t1);
+    rows[1] = _mm_movehl_ps(t1, t0);
+    rows[2] = _mm_movelh_ps(t2, t3);
+    rows[3] = _mm_movehl_ps(t3, t2);
+}
+
+NEO_SSE2_FUNC_DEF void load_transposed4(const float* pointer, size_t stride, floatv* fields) {
+    for (int l = 0; l < 4; l++) fields[l] = _mm_loadu_ps(pointer + l * stride);
+    transpose4(fields);
+}
+
+NEO_SSE2_FUNC_DEF void store_transposed4(const floatv* fields, float* pointer, size_t stride) {
+    floatv rows[4] = { fields[0], fields[1], fields[2], fields[3] };
+    transpose4(rows);
+    for (int l = 0; l < 4; l++) _mm_storeu_ps(pointer + l * stride, rows[l].v);
+}
+
+}
+
+#endif
+
+#if NEO_SIMD >= NEO_SIMD_AVX2 || NEO_DISPATCH_AVX2
+
+namespace avx2 {
+
+struct intv;
+
+struct floatv {
+
+    enum { width = 8 };
+    typedef simd::avx2::intv int_type;
+
+    __m256 v;
+
+    NEO_AVX2_FUNC_DEF floatv() { }
+    NEO_AVX2_FUNC_DEF floatv(float scalar): v(_mm256_set1_ps(scalar)) { }
+    NEO_AVX2_FUNC_DEF floatv(__m256 v): v(v) { }
+
+    static NEO_AVX2_FUNC_DEF floatv load(const float* pointer) { return _mm256_loadu_ps(pointer); }
+    static NEO_AVX2_FUNC_DEF floatv load(const float* pointer, int count) {
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        return _mm256_maskload_ps(pointer, _mm256_cmpgt_epi32(_mm256_set1_epi32(count), lanes));
+    }
+    static NEO_AVX2_FUNC_DEF floatv load_strided(const float* pointer, size_t stride, int count) {
+        if (count == 8) {
+            return _mm256_setr_ps(pointer[0], pointer[stride], pointer[2 * stride], pointer[3 * stride],
+                pointer[4 * stride], pointer[5 * stride], pointer[6 * stride], pointer[7 * stride]);
+        }
+        float lanes[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < count; i++) lanes[i] = pointer[i * stride];
+        return _mm256_loadu_ps(lanes);
+    }
+    NEO_AVX2_FUNC_DEF void store(float* pointer) const { _mm256_storeu_ps(pointer, v); }
+    NEO_AVX2_FUNC_DEF void store(float* pointer, int count) const {
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        _mm256_maskstore_ps(pointer, _mm256_cmpgt_epi32(_mm256_set1_epi32(count), lanes), v);
+    }
+
+    NEO_AVX2_FUNC_DEF float operator[](int index) const { float lanes[8]; _mm256_storeu_ps(lanes, v); return lanes[index]; }
+
+};
+
+struct intv {
+
+    enum { width = 8 };
+
+    __m256i v;
+
+    NEO_AVX2_FUNC_DEF intv() { }
+    NEO_AVX2_FUNC_DEF intv(int32_t scalar): v(_mm256_set1_epi32(scalar)) { }
+    NEO_AVX2_FUNC_DEF intv(__m256i v): v(v) { }
+
+    static NEO_AVX2_FUNC_DEF intv load(const uint32_t* pointer) { return _mm256_loadu_si256((const __m256i*)pointer); }
+    static NEO_AVX2_FUNC_DEF intv load(const uint32_t* pointer, int count) {
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        return _mm256_maskload_epi32((const int*)pointer, _mm256_cmpgt_epi32(_mm256_set1_epi32(count), lanes));
+    }
+    NEO_AVX2_FUNC_DEF void store(uint32_t* pointer) const { _mm256_storeu_si256((__m256i*)pointer, v); }
+    NEO_AVX2_FUNC_DEF void store(uint32_t* pointer, int count) const {
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        _mm256_maskstore_epi32((int*)pointer, _mm256_cmpgt_epi32(_mm256_set1_epi32(count), lanes), v);
+    }
+
+    NEO_AVX2_FUNC_DEF uint32_t operator[](int index) const { uint32_t lanes[8]; _mm256_storeu_si256((__m256i*)lanes, v); return lanes[index]; }
+
+};
+
+NEO_AVX2_FUNC_DEF floatv operator-(const floatv& v) { return _mm256_xor_ps(v.v, _mm256_set1_ps(-0.0f)); }
+NEO_AVX2_FUNC_DEF floatv operator+(const floatv& lhs, const floatv& rhs) { return _mm256_add_ps(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF floatv operator-(const floatv& lhs, const floatv& rhs) { return _mm256_sub_ps(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF floatv operator*(const floatv& lhs, const floatv& rhs) { return _mm256_mul_ps(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF floatv operator/(const floatv& lhs, const floatv& rhs) { return _mm256_div_ps(lhs.v, rhs.v); }
+
+NEO_AVX2_FUNC_DEF floatv operator<(const floatv& lhs, const floatv& rhs) { return _mm256_cmp_ps(lhs.v, rhs.v, _CMP_LT_OQ); }
+NEO_AVX2_FUNC_DEF floatv operator<=(const floatv& lhs, const floatv& rhs) { return _mm256_cmp_ps(lhs.v, rhs.v, _CMP_LE_OQ); }
+NEO_AVX2_FUNC_DEF floatv operator>(const floatv& lhs, const floatv& rhs) { return _mm256_cmp_ps(lhs.v, rhs.v, _CMP_GT_OQ); }
+NEO_AVX2_FUNC_DEF floatv operator>=(const floatv& lhs, const floatv& rhs) { return _mm256_cmp_ps(lhs.v, rhs.v, _CMP_GE_OQ); }
+NEO_AVX2_FUNC_DEF floatv operator==(const floatv& lhs, const floatv& rhs) { return _mm256_cmp_ps(lhs.v, rhs.v, _CMP_EQ_OQ); }
+NEO_AVX2_FUNC_DEF floatv operator!=(const floatv& lhs, const floatv& rhs) { return _mm256_cmp_ps(lhs.v, rhs.v, _CMP_NEQ_UQ); }
+
+NEO_AVX2_FUNC_DEF floatv operator&(const floatv& lhs, const floatv& rhs) { return _mm256_and_ps(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF floatv operator|(const floatv& lhs, const floatv& rhs) { return _mm256_or_ps(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF floatv operator^(const floatv& lhs, const floatv& rhs) { return _mm256_xor_ps(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF floatv andnot(const floatv& lhs, const floatv& rhs) { return _mm256_andnot_ps(lhs.v, rhs.v); }
+
+NEO_AVX2_FUNC_DEF floatv fmadd(const floatv& a, const floatv& b, const floatv& c) { return _mm256_fmadd_ps(a.v, b.v, c.v); }
+NEO_AVX2_FUNC_DEF floatv fnmadd(const floatv& a, const floatv& b, const floatv& c) { return _mm256_fnmadd_ps(a.v, b.v, c.v); }
+NEO_AVX2_FUNC_DEF floatv min(const floatv& lhs, const floatv& rhs) { return _mm256_min_ps(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF floatv max(const floatv& lhs, const floatv& rhs) { return _mm256_max_ps(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF floatv abs(const floatv& v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v.v); }
+NEO_AVX2_FUNC_DEF floatv sqrt(const floatv& v) { return _mm256_sqrt_ps(v.v); }
+
+NEO_AVX2_FUNC_DEF floatv rsqrt(const floatv& v) {
+    __m256 estimate = _mm256_rsqrt_ps(v.v);
+    __m256 half_v_estimate = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), v.v), estimate);
+    return _mm256_mul_ps(estimate, _mm256_fnmadd_ps(half_v_estimate, estimate, _mm256_set1_ps(1.5f)));
+}
+
+NEO_AVX2_FUNC_DEF floatv floor(const floatv& v) { return _mm256_floor_ps(v.v); }
+NEO_AVX2_FUNC_DEF floatv select(const floatv& mask, const floatv& lhs, const floatv& rhs) { return _mm256_blendv_ps(rhs.v, lhs.v, mask.v); }
+
+NEO_AVX2_FUNC_DEF int mask_bits(const floatv& mask) { return _mm256_movemask_ps(mask.v); }
+NEO_AVX2_FUNC_DEF bool any(const floatv& mask) { return _mm256_movemask_ps(mask.v) != 0; }
+NEO_AVX2_FUNC_DEF bool all(const floatv& mask) { return _mm256_movemask_ps(mask.v) == 0xFF; }
+
+NEO_AVX2_FUNC_DEF float reduce_add(const floatv& v) {
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(v.v), _mm256_extractf128_ps(v.v, 1));
+    __m128 pairs = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehdup_ps(pairs)));
+}
+
+NEO_AVX2_FUNC_DEF float reduce_min(const floatv& v) {
+    __m128 half = _mm_min_ps(_mm256_castps256_ps128(v.v), _mm256_extractf128_ps(v.v, 1));
+    __m128 pairs = _mm_min_ps(half, _mm_movehl_ps(half, half));
+    return _mm_cvtss_f32(_mm_min_ss(pairs, _mm_movehdup_ps(pairs)));
+}
+
+NEO_AVX2_FUNC_DEF float reduce_max(const floatv& v) {
+    __m128 half = _mm_max_ps(_mm256_castps256_ps128(v.v), _mm256_extractf128_ps(v.v, 1));
+    __m128 pairs = _mm_max_ps(half, _mm_movehl_ps(half, half));
+    return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_movehdup_ps(pairs)));
+}
+
+NEO_AVX2_FUNC_DEF intv operator+(const intv& lhs, const intv& rhs) { return _mm256_add_epi32(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF intv operator-(const intv& lhs, const intv& rhs) { return _mm256_sub_epi32(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF intv operator*(const intv& lhs, const intv& rhs) { return _mm256_mullo_epi32(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF intv operator&(const intv& lhs, const intv& rhs) { return _mm256_and_si256(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF intv operator|(const intv& lhs, const intv& rhs) { return _mm256_or_si256(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF intv operator^(const intv& lhs, const intv& rhs) { return _mm256_xor_si256(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF intv andnot(const intv& lhs, const intv& rhs) { return _mm256_andnot_si256(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF intv operator<<(const intv& v, int count) { return _mm256_sll_epi32(v.v, _mm_cvtsi32_si128(count)); }
+NEO_AVX2_FUNC_DEF intv operator>>(const intv& v, int count) { return _mm256_srl_epi32(v.v, _mm_cvtsi32_si128(count)); }
+
+NEO_AVX2_FUNC_DEF intv operator==(const intv& lhs, const intv& rhs) { return _mm256_cmpeq_epi32(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF intv operator<(const intv& lhs, const intv& rhs) { return _mm256_cmpgt_epi32(rhs.v, lhs.v); }
+NEO_AVX2_FUNC_DEF intv operator>(const intv& lhs, const intv& rhs) { return _mm256_cmpgt_epi32(lhs.v, rhs.v); }
+NEO_AVX2_FUNC_DEF intv select(const intv& mask, const intv& lhs, const intv& rhs) { return _mm256_blendv_epi8(rhs.v, lhs.v, mask.v); }
+
+NEO_AVX2_FUNC_DEF intv to_int(const floatv& v) { return _mm256_cvttps_epi32(v.v); }
+NEO_AVX2_FUNC_DEF intv round_to_int(const floatv& v) { return _mm256_cvtps_epi32(v.v); }
+NEO_AVX2_FUNC_DEF floatv to_float(const intv& v) { return _mm256_cvtepi32_ps(v.v); }
+NEO_AVX2_FUNC_DEF intv as_int(const floatv& v) { return _mm256_castps_si256(v.v); }
+NEO_AVX2_FUNC_DEF floatv as_float(const intv& v) { return _mm256_castsi256_ps(v.v); }
+
+// Permutes within each group of four lanes.
+template <int X, int Y, int Z, int W>
+NEO_AVX2_FUNC_DEF floatv shuffle(const floatv& v) { return _mm256_permute_ps(v.v, _MM_SHUFFLE(W, Z, Y, X)); }
+
+// Transposes the lower and the upper 4x4 blocks independently.
+NEO_AVX2_FUNC_DEF void transpose4(floatv* rows) {
+    __m256 t0 = _mm256_unpacklo_ps(rows[0].v, rows[1].v);
+    __m256 t1 = _mm256_unpacklo_ps(rows[2].v, rows[3].v);
+    __m256 t2 = _mm256_unpackhi_ps(rows[0].v, rows[1].v);
+    __m256 t3 = _mm256_unpackhi_ps(rows[2].v, rows[3].v);
+    rows[0] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    rows[1] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    rows[2] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    rows[3] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+// Lanes 0 to 3 come from the lower halves and lanes 4 to 7 from the upper halves of the rows.
+NEO_AVX2_FUNC_DEF void load_transposed4(const float* pointer, size_t stride, floatv* fields) {
+    for (int l = 0; l < 4; l++) {
+        __m128 lower = _mm_loadu_ps(pointer + l * stride);
+        __m128 upper = _mm_loadu_ps(pointer + (l + 4) * stride);
+        fields[l] = _mm256_insertf128_ps(_mm256_castps128_ps256(lower), upper, 1);
+    }
+    transpose4(fields);
+}
+
+// Lanes are written in ascending order, so a stride of 3 leaves every element intact and only
+// overwrites the float following the last one.
+NEO_AVX2_FUNC_DEF void store_transposed4(const floatv* fields, float* pointer, size_t stride) {
+    floatv rows[4] = { fields[0], fields[1], fields[2], fields[3] };
+    transpose4(rows);
+    for (int l = 0; l < 4; l++) _mm_storeu_ps(pointer + l * stride, _mm256_castps256_ps128(rows[l].v));
+    for (int l = 0; l < 4; l++) _mm_storeu_ps(pointer + (l + 4) * stride, _mm256_extractf128_ps(rows[l].v, 1));
+}
+
+}
+
+#endif
+
+#if NEO_SIMD >= NEO_SIMD_AVX2
+namespace native = avx2;
+#elif NEO_SIMD >= NEO_SIMD_SSE2
+namespace native = sse2;
+#else
+namespace native = scalar;
+#endif
+
+enum target { TARGET_SCALAR, TARGET_SSE2, TARGET_AVX2 };
+
+NEO_FUNC_DEF const char* name(target t) {
+    return t == TARGET_AVX2 ? "avx2" : t == TARGET_SSE2 ? "sse2" : "scalar";
+}
+
+// Best backend the processor and operating system support, limited to the backends compiled in.
+inline target supported() {
+#if NEO_DISPATCH_AVX2
+    unsigned int registers[4] = { 0, 0, 0, 0 };
+#if defined(_MSC_VER)
+    __cpuidex((int*)registers, 0, 0);
+    unsigned int leaves = registers[0];
+    __cpuidex((int*)registers, 1, 0);
+#else
+    unsigned int leaves = __get_cpuid_max(0, nullptr);
+    __cpuid_count(1, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    bool fma = (registers[2] >> 12 & 1) != 0;
+    bool osxsave = (registers[2] >> 27 & 1) != 0;
+    bool avx = (registers[2] >> 28 & 1) != 0;
+    if (leaves < 7 || !fma || !osxsave || !avx) return TARGET_SSE2;
+
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int xcr0_low, xcr0_high;
+    __asm__ ("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    unsigned long long xcr0 = (unsigned long long)xcr0_high << 32 | xcr0_low;
+#endif
+    if ((xcr0 & 6) != 6) return TARGET_SSE2;
+
+#if defined(_MSC_VER)
+    __cpuidex((int*)registers, 7, 0);
+#else
+    __cpuid_count(7, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    return (registers[1] >> 5 & 1) != 0 ? TARGET_AVX2 : TARGET_SSE2;
+#elif NEO_SIMD >= NEO_SIMD_AVX2
+    return TARGET_AVX2;
+#elif NEO_SIMD >= NEO_SIMD_SSE2
+    return TARGET_SSE2;
+#else
+    return TARGET_SCALAR;
+#endif
+}
+
+// Backend used by dispatched kernels, chosen on first use. The NEO_SIMD environment variable
+// ("scalar", "sse2" or "avx2") can lower it, e.g. to compare results between paths.
+inline target active() {
+#if NEO_DISPATCH_AVX2
+    static const target selected = []() {
+        target best = supported();
+        const char* variable = std::getenv("NEO_SIMD");
+        if (variable == nullptr) return best;
+        for (int t = TARGET_SCALAR; t <= best; t++) {
+            if (std::strcmp(variable, name((target)t)) == 0) return (target)t;
+        }
+        return best;
+    }();
+    return selected;
+#else
+    return supported();
+#endif
+}
+
+#if NEO_DISPATCH_AVX2
+template <class Kernel, class... Arguments>
+NEO_AVX2_TARGET NEO_FLATTEN auto run_avx2(Arguments... arguments) -> decltype(Kernel::template run<avx2::floatv>(arguments...)) {
+    return Kernel::template run<avx2::floatv>(arguments...);
+}
+#endif
+
+// Calls Kernel::run<V>(arguments...) with the floatv type of the active backend. Kernels must be
+// plain loops over their range without indirect calls, so that they inline into the AVX2 entry.
+template <class Kernel, class... Arguments>
+inline auto dispatch(Arguments... arguments) -> decltype(Kernel::template run<native::floatv>(arguments...)) {
+#if NEO_DISPATCH_AVX2
+    switch (active()) {
+    case TARGET_AVX2: return run_avx2<Kernel>(arguments...);
+    case TARGET_SCALAR: return Kernel::template run<scalar::floatv>(arguments...);
+    default: break;
+    }
+#endif
+    return Kernel::template run<native::floatv>(arguments...);
+}
+
+// Plain float overloads so that templated kernels also compile for a single lane.
+NEO_FUNC_DEF float select(bool mask, float lhs, float rhs) { return mask ? lhs : rhs; }
+NEO_FUNC_DEF float fmadd(float a, float b, float c) { return a * b + c; }
+NEO_FUNC_DEF float fnmadd(float a, float b, float c) { return c - a * b; }
+NEO_FUNC_DEF float min(float lhs, float rhs) { return lhs < rhs ? lhs : rhs; }
+NEO_FUNC_DEF float max(float lhs, float rhs) { return lhs > rhs ? lhs : rhs; }
+NEO_FUNC_DEF float abs(float v) { return fabsf(v); }
+NEO_FUNC_DEF float sqrt(float v) { return sqrtf(v); }
+NEO_FUNC_DEF float rsqrt(float v) { return 1.0f / sqrtf(v); }
+
+template <class V>
+inline V load_strided(const float* pointer, size_t stride, int count = V::width) {
+    return V::load_strided(pointer, stride, count);
+}
+
+template <class V>
+inline void store_strided(const V& v, float* pointer, size_t stride, int count = V::width) {
+    float lanes[V::width];
+    v.store(lanes);
+    for (int i = 0; i < count; i++) pointer[i * stride] = lanes[i];
+}
+
+// Splits count consecutive records of n floats into n registers, one per field, and back. Full
+// blocks move four fields at a time through register transposes; the rest goes lane by lane.
+template <class V>
+inline void load_interleaved(const float* pointer, V* fields, int n, int count = V::width) {
+    int i = 0;
+    if (count == V::width) {
+        for (; i + 4 <= n; i += 4) load_transposed4(pointer + i, n, fields + i);
+    }
+    for (; i < n; i++) fields[i] = load_strided<V>(pointer + i, n, count);
+}
+
+template <class V>
+inline void store_interleaved(const V* fields, float* pointer, int n, int count = V::width) {
+    int i = 0;
+    if (count == V::width) {
+        for (; i + 4 <= n; i += 4) store_transposed4(fields + i, pointer + i, n);
+    }
+    for (; i < n; i++) store_strided(fields[i], pointer + i, n, count);
+}
+
+// Cephes-style sine and cosine: three-part Cody-Waite reduction to [-pi/4, pi/4] followed by
+// minimax polynomials. Absolute error stays below 1e-7 for |angle| <= 8192.
+template <class V>
+inline void sincos(const V& angle, V& sine, V& cosine) {
+    typedef typename V::int_type I;
+
+    V x = abs(angle);
+    V sign_sine = angle & V(-0.0f);
+
+    I quadrant = to_int(x * V(1.27323954473516f));
+    quadrant = (quadrant + I(1)) & I(~1);
+    V y = to_float(quadrant);
+
+    V swap_sign_sine = as_float((quadrant & I(4)) << 29);
+    V polynomial_mask = as_float((quadrant & I(2)) == I(0));
+    V sign_cosine = as_float(andnot(quadrant - I(2), I(4)) << 29);
+    sign_sine = sign_sine ^ swap_sign_sine;
+
+    x = fnmadd(y, V(0.78515625f), x);
+    x = fnmadd(y, V(2.4187564849853515625e-4f), x);
+    x = fnmadd(y, V(3.77489497744594108e-8f), x);
+
+    V z = x * x;
+
+    V cosine_polynomial = fmadd(V(2.443315711809948e-5f), z, V(-1.388731625493765e-3f));
+    cosine_polynomial = fmadd(cosine_polynomial, z, V(4.166664568298827e-2f));
+    cosine_polynomial = cosine_polynomial * z * z;
+    cosine_polynomial = fnmadd(V(0.5f), z, cosine_polynomial) + V(1.0f);
+
+    V sine_polynomial = fmadd(V(-1.9515295891e-4f), z, V(8.3321608736e-3f));
+    sine_polynomial = fmadd(sine_polynomial, z, V(-1.6666654611e-1f));
+    sine_polynomial = fmadd(sine_polynomial * z, x, x);
+
+    sine = select(polynomial_mask, sine_polynomial, cosine_polynomial) ^ sign_sine;
+    cosine = select(polynomial_mask, cosine_polynomial, sine_polynomial) ^ sign_cosine;
+}
+
+}
+}
+
+#endif
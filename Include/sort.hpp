@@ -0,0 +1,91 @@
+#ifndef SORT_HPP
+#define SORT_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+// Least significant digit first with 8 bit digits. Every pass builds one histogram per block of
+// keys, turns them into per-block output offsets (digit-major, so the sort is stable) and lets each
+// block scatter its keys independently. Passes whose digit is the same for all keys are skipped.
+template <class Key>
+inline void radix_sort(Key* keys, uint32_t* values, size_t count) {
+    const size_t grain = 1 << 16;
+    const int RADIX = 256;
+
+    size_t blocks = (count + grain - 1) / grain;
+    std::vector<Key> key_buffer(count);
+    std::vector<uint32_t> value_buffer(values != nullptr ? count : 0);
+    std::vector<size_t> histograms(blocks * RADIX);
+
+    Key* source_keys = keys;
+    Key* target_keys = key_buffer.data();
+    uint32_t* source_values = values;
+    uint32_t* target_values = values != nullptr ? value_buffer.data() : nullptr;
+
+    for (int shift = 0; shift < (int)sizeof(Key) * 8; shift += 8) {
+        parallel_for(count, grain, [&](size_t begin, size_t end) {
+            size_t* histogram = &histograms[begin / grain * RADIX];
+            std::fill(histogram, histogram + RADIX, 0);
+            for (size_t i = begin; i < end; i++) histogram[(source_keys[i] >> shift) & (RADIX - 1)]++;
+        });
+
+        size_t offset = 0;
+        bool trivial = false;
+        for (int digit = 0; digit < RADIX; digit++) {
+            size_t digit_start = offset;
+            for (size_t b = 0; b < blocks; b++) {
+                size_t block_count = histograms[b * RADIX + digit];
+                histograms[b * RADIX + digit] = offset;
+                offset += block_count;
+            }
+            if (offset - digit_start == count) trivial = true;
+        }
+        if (trivial) continue;
+
+        parallel_for(count, grain, [&](size_t begin, size_t end) {
+            size_t* cursor = &histograms[begin / grain * RADIX];
+            for (size_t i = begin; i < end; i++) {
+                size_t slot = cursor[(source_keys[i] >> shift) & (RADIX - 1)]++;
+                target_keys[slot] = source_keys[i];
+                if (source_values != nullptr) target_values[slot] = source_values[i];
+            }
+        });
+
+        std::swap(source_keys, target_keys);
+        std::swap(source_values, target_values);
+    }
+
+    if (source_keys != keys) {
+        parallel_for(count, grain, [&](size_t begin, size_t end) {
+            std::copy(source_keys + begin, source_keys + end, keys + begin);
+            if (values != nullptr) std::copy(source_values + begin, source_values + end, values + begin);
+        });
+    }
+}
+
+}
+
+NEO_BATCH_FUNC_DEF void radix_sort(uint32_t* keys, uint32_t* values, size_t count) {
+    detail::radix_sort(keys, values, count);
+}
+
+NEO_BATCH_FUNC_DEF void radix_sort(uint64_t* keys, uint32_t* values, size_t count) {
+    detail::radix_sort(keys, values, count);
+}
+
+// Gathers destination[i] = source[order[i]], e.g. to apply the values of an index sort to payloads.
+template <class T>
+inline void permute(const T* source, const uint32_t* order, T* destination, size_t count) {
+    parallel_for(count, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) destination[i] = source[order[i]];
+    });
+}
+
+}
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef SPATIAL_HASH_HPP
+#define SPATIAL_HASH_HPP
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+// Bucket of the cell holding each position, with the hash of spatial_hash::hash.
+struct spatial_hash_buckets_kernel {
+    template <class V>
+    static void run(const float* positions, float inverse_cell_size, uint32_t mask, uint32_t* buckets, size_t begin, size_t end) {
+        typedef typename V::int_type I;
+
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+            I x = to_int(floor(simd::load_strided<V>(positions + 3 * i, 3, lanes) * V(inverse_cell_size)));
+            I y = to_int(floor(simd::load_strided<V>(positions + 3 * i + 1, 3, lanes) * V(inverse_cell_size)));
+            I z = to_int(floor(simd::load_strided<V>(positions + 3 * i + 2, 3, lanes) * V(inverse_cell_size)));
+            I bucket = (x * I(73856093) ^ y * I(19349663) ^ z * I(83492791)) & I((int32_t)mask);
+            bucket.store(buckets + i, lanes);
+        }
+    }
+};
+
+}
+
+// Uniform grid of cubic cells hashed into a power of two table, so unbounded domains cost memory
+// proportional to the point count. Points are counting-sorted by bucket into contiguous storage on
+// every build; within a bucket they keep their input order, so rebuilds are deterministic.
+// Neighbor queries visit the cells overlapping the query sphere, at most 27 while the radius does
+// not exceed the cell size; ranges of more cells than the table has buckets scan every bucket.
+class spatial_hash {
+
+public:
+
+    NEO_BATCH_FUNC_DECL spatial_hash(): cell_size(1.0f), mask(0) { }
+    NEO_BATCH_FUNC_DECL spatial_hash(const float3* positions, size_t count, float cell_size) { build(positions, count, cell_size); }
+
+    NEO_BATCH_FUNC_DECL void build(const float3* positions, size_t count, float cell_size);
+
+    NEO_BATCH_FUNC_DECL size_t size() const { return sorted_indices.size(); }
+
+    // Points in bucket order together with their indices in the array the grid was built from.
+    NEO_BATCH_FUNC_DECL const float3* positions() const { return sorted_positions.data(); }
+    NEO_BATCH_FUNC_DECL const uint32_t* indices() const { return sorted_indices.data(); }
+
+    // Calls visit(index, position, distance_squared) for every point within radius of position.
+    template <class Visit>
+    void for_each_neighbor(const float3& position, float radius, const Visit& visit) const;
+
+    // Appends the indices of all points within radius and returns their number.
+    NEO_BATCH_FUNC_DECL size_t radius(const float3& query, float radius, std::vector<uint32_t>& neighbors) const;
+    // Neighbors of query i are neighbors[offsets[i]] up to neighbors[offsets[i + 1]].
+    NEO_BATCH_FUNC_DECL void radius(const float3* queries, size_t count, float radius, std::vector<uint32_t>& offsets, std::vector<uint32_t>& neighbors) const;
+
+private:
+
+    float cell_size;
+    uint32_t mask;
+    std::vector<uint32_t> buckets, partitioned_buckets, partitioned_indices, bucket_starts, sorted_indices;
+    std::vector<float3> sorted_positions;
+
+    static NEO_BATCH_FUNC_DECL uint32_t hash(int32_t x, int32_t y, int32_t z, uint32_t mask) {
+        return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u) & mask;
+    }
+
+};
+
+NEO_BATCH_FUNC_DEF void spatial_hash::build(const float3* positions, size_t count, float cell_size) {
+    const size_t grain = 1 << 14;
+    this->cell_size = cell_size;
+
+    size_t table = 1;
+    while (table < count) table *= 2;
+    mask = (uint32_t)table - 1;
+
+    buckets.resize(count);
+    float inverse_cell_size = 1.0f / cell_size;
+    uint32_t* bucket_data = buckets.data();
+    parallel_for(count, grain, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::spatial_hash_buckets_kernel>(&positions[0].x, inverse_cell_size, mask, bucket_data, begin, end);
+    });
+
+    // Stable counting sort in two passes without atomics: points are first distributed into
+    // partitions of consecutive buckets using per-block histograms, then every partition sorts its
+    // own bucket range independently with tables that stay in cache.
+    int table_bits = 0;
+    while (((size_t)1 << table_bits) < table) table_bits++;
+    int shift = table_bits > 8 ? table_bits - 8 : 0;
+    size_t partitions = table >> shift;
+    size_t blocks = (count + grain - 1) / grain;
+
+    std::vector<uint32_t> histograms(blocks * partitions, 0);
+    parallel_for(count, grain, [&](size_t begin, size_t end) {
+        uint32_t* histogram = &histograms[begin / grain * partitions];
+        for (size_t i = begin; i < end; i++) histogram[buckets[i] >> shift]++;
+    });
+
+    std::vector<uint32_t> partition_starts(partitions + 1);
+    uint32_t total = 0;
+    for (size_t p = 0; p < partitions; p++) {
+        partition_starts[p] = total;
+        for (size_t b = 0; b < blocks; b++) {
+            uint32_t block_count = histograms[b * partitions + p];
+            histograms[b * partitions + p] = total;
+            total += block_count;
+        }
+    }
+    partition_starts[partitions] = total;
+
+    partitioned_buckets.resize(count);
+    partitioned_indices.resize(count);
+    parallel_for(count, grain, [&](size_t begin, size_t end) {
+        uint32_t* cursor = &histograms[begin / grain * partitions];
+        for (size_t i = begin; i < end; i++) {
+            uint32_t slot = cursor[buckets[i] >> shift]++;
+            partitioned_buckets[slot] = buckets[i];
+            partitioned_indices[slot] = (uint32_t)i;
+        }
+    });
+
+    bucket_starts.resize(table + 1);
+    sorted_indices.resize(count);
+    sorted_positions.resize(count);
+    parallel_for(partitions, 1, [&](size_t begin, size_t end) {
+        std::vector<uint32_t> cursors((size_t)1 << shift);
+        for (size_t p = begin; p < end; p++) {
+            uint32_t first_bucket = (uint32_t)(p << shift);
+            std::fill(cursors.begin(), cursors.end(), 0);
+            for (uint32_t i = partition_starts[p]; i < partition_starts[p + 1]; i++) cursors[partitioned_buckets[i] - first_bucket]++;
+
+            uint32_t start = partition_starts[p];
+            for (size_t b = 0; b < cursors.size(); b++) {
+                bucket_starts[first_bucket + b] = start;
+                start += cursors[b];
+                cursors[b] = bucket_starts[first_bucket + b];
+            }
+
+            for (uint32_t i = partition_starts[p]; i < partition_starts[p + 1]; i++) {
+                uint32_t slot = cursors[partitioned_buckets[i] - first_bucket]++;
+                sorted_indices[slot] = partitioned_indices[i];
+                sorted_positions[slot] = positions[partitioned_indices[i]];
+            }
+        }
+    });
+    bucket_starts[table] = (uint32_t)count;
+}
+
+template <class Visit>
+inline void spatial_hash::for_each_neighbor(const float3& position, float radius, const Visit& visit) const {
+    if (sorted_indices.empty()) return;
+
+    float inverse_cell_size = 1.0f / cell_size;
+    int32_t lower[3], upper[3];
+    for (int axis = 0; axis < 3; axis++) {
+        lower[axis] = (int32_t)floorf((position[axis] - radius) * inverse_cell_size);
+        upper[axis] = (int32_t)floorf((position[axis] + radius) * inverse_cell_size);
+    }
+
+    // Distinct cells may share a bucket; each bucket is scanned once.
+    uint64_t cells = 1;
+    for (int axis = 0; axis < 3 && cells <= mask; axis++) cells *= (uint64_t)((int64_t)upper[axis] - lower[axis] + 1);
+    uint32_t nearby[27];
+    std::vector<uint32_t> spilled;
+    uint32_t* visited = nearby;
+    size_t visited_count = 0;
+    if (cells > mask) {
+        spilled.resize((size_t)mask + 1);
+        for (uint32_t bucket = 0; bucket <= mask; bucket++) spilled[bucket] = bucket;
+        visited = spilled.data();
+        visited_count = spilled.size();
+    } else {
+        if (cells > 27) {
+            spilled.resize((size_t)cells);
+            visited = spilled.data();
+        }
+        for (int32_t z = lower[2]; z <= upper[2]; z++) {
+            for (int32_t y = lower[1]; y <= upper[1]; y++) {
+                for (int32_t x = lower[0]; x <= upper[0]; x++) visited[visited_count++] = hash(x, y, z, mask);
+            }
+        }
+        std::sort(visited, visited + visited_count);
+        visited_count = std::unique(visited, visited + visited_count) - visited;
+    }
+
+    float radius_squared = radius * radius;
+    for (size_t b = 0; b < visited_count; b++) {
+        for (uint32_t i = bucket_starts[visited[b]]; i < bucket_starts[visited[b] + 1]; i++) {
+            float3 difference = sorted_positions[i] - position;
+            float distance_squared = dot(difference, difference);
+            if (distance_squared <= radius_squared) visit(sorted_indices[i], sorted_positions[i], distance_squared);
+        }
+    }
+}
+
+NEO_BATCH_FUNC_DEF size_t spatial_hash::radius(const float3& query, float radius, std::vector<uint32_t>& neighbors) const {
+    size_t previous = neighbors.size();
+    for_each_neighbor(query, radius, [&neighbors](uint32_t index, const float3&, float) { neighbors.push_back(index); });
+    return neighbors.size() - previous;
+}
+
+NEO_BATCH_FUNC_DEF void spatial_hash::radius(const float3* queries, size_t count, float radius, std::vector<uint32_t>& offsets, std::vector<uint32_t>& neighbors) const {
+    const size_t grain = 256;
+    size_t blocks = (count + grain - 1) / grain;
+    std::vector<std::vector<uint32_t> > block_neighbors(blocks);
+
+    offsets.assign(count + 1, 0);
+    parallel_for(count, grain, [&](size_t begin, size_t end) {
+        std::vector<uint32_t>& local = block_neighbors[begin / grain];
+        for (size_t i = begin; i < end; i++) offsets[i + 1] = (uint32_t)this->radius(queries[i], radius, local);
+    });
+
+    for (size_t i = 0; i < count; i++) offsets[i + 1] += offsets[i];
+
+    neighbors.resize(offsets[count]);
+    parallel_for(blocks, 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) std::copy(block_neighbors[b].begin(), block_neighbors[b].end(), neighbors.begin() + offsets[b * grain]);
+    });
+}
+
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef SPLINE_HPP
+#define SPLINE_HPP
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+namespace detail {
+
+// Evaluates the power basis segments (4 * N floats each) of a spline, or their derivatives, at
+// clamped parameters. Lanes usually fall into the same segment when parameters are ordered, in
+// which case the coefficients are broadcast instead of gathered lane by lane.
+template <int N, bool Derivative>
+struct spline_kernel {
+    template <class V>
+    static void run(const float* coefficients, size_t segments, const float* parameters, float* output, size_t begin, size_t end) {
+        const int STRIDE = 4 * N;
+        V segment_count((float)segments), last_segment((float)(segments - 1));
+        for (size_t i = begin; i < end; i += V::width) {
+            int lanes = end - i < (size_t)V::width ? (int)(end - i) : (int)V::width;
+
+            V u = min(max(V::load(parameters + i, lanes), V(0.0f)), V(1.0f)) * segment_count;
+            V segment = min(floor(u), last_segment);
+            u = u - segment;
+
+            uint32_t indices[V::width];
+            to_int(segment).store(indices);
+
+            V c[4][N];
+            bool uniform = true;
+            for (int l = 1; l < lanes; l++) uniform = uniform && indices[l] == indices[0];
+            if (uniform) {
+                const float* first = coefficients + indices[0] * STRIDE;
+                for (int p = 0; p < 4; p++) {
+                    for (int k = 0; k < N; k++) c[p][k] = V(first[p * N + k]);
+                }
+            } else {
+                float gathered[STRIDE][V::width] = { };
+                for (int l = 0; l < lanes; l++) {
+                    const float* first = coefficients + indices[l] * STRIDE;
+                    for (int j = 0; j < STRIDE; j++) gathered[j][l] = first[j];
+                }
+                for (int p = 0; p < 4; p++) {
+                    for (int k = 0; k < N; k++) c[p][k] = V::load(gathered[p * N + k]);
+                }
+            }
+
+            for (int k = 0; k < N; k++) {
+                V result;
+                if (Derivative) result = fmadd(fmadd(c[3][k] * V(3.0f), u, c[2][k] * V(2.0f)), u, c[1][k]) * segment_count;
+                else result = fmadd(fmadd(fmadd(c[3][k], u, c[2][k]), u, c[1][k]), u, c[0][k]);
+                simd::store_strided(result, output + i * N + k, N, lanes);
+            }
+        }
+    }
+};
+
+}
+
+// Piecewise cubic curve over float2, float3 or float4. Every segment is converted to power basis
+// c0 + c1 u + c2 u^2 + c3 u^3 on construction, so all spline kinds are evaluated with the same
+// Horner scheme. The parameter t runs from 0 to 1 over the whole curve, each segment covering an
+// equal share of it.
+template <class T>
+class spline {
+
+public:
+
+    enum { COMPONENTS = sizeof(T) / sizeof(float) };
+
+    NEO_BATCH_FUNC_DECL spline(): segments(0) { }
+
+    // Uniform Catmull-Rom through all count points; end tangents repeat the end points.
+    static NEO_BATCH_FUNC_DECL spline catmull_rom(const T* points, size_t count);
+    // Cubic Bezier segments sharing end points: 3 n + 1 control points give n segments.
+    static NEO_BATCH_FUNC_DECL spline bezier(const T* control_points, size_t count);
+    // Hermite segments between consecutive points with the tangents given at each point.
+    static NEO_BATCH_FUNC_DECL spline hermite(const T* points, const T* tangents, size_t count);
+
+    NEO_BATCH_FUNC_DECL size_t segment_count() const { return segments; }
+
+    NEO_BATCH_FUNC_DECL T evaluate(float t) const;
+    // Derivative with respect to t, i.e. scaled by the segment count.
+    NEO_BATCH_FUNC_DECL T derivative(float t) const;
+
+    NEO_BATCH_FUNC_DECL void evaluate(const float* parameters, T* values, size_t count) const;
+    NEO_BATCH_FUNC_DECL void derivative(const float* parameters, T* tangents, size_t count) const;
+
+    // Tabulates arc length at samples_per_segment steps per segment; needed by length and parameter.
+    NEO_BATCH_FUNC_DECL void build_arc_length_table(size_t samples_per_segment = 32);
+    NEO_BATCH_FUNC_DECL float length() const { return arc_lengths.empty() ? 0.0f : arc_lengths.back(); }
+    // Maps a distance along the curve to the parameter t, interpolating the table linearly.
+    NEO_BATCH_FUNC_DECL float parameter(float distance) const;
+    NEO_BATCH_FUNC_DECL void parameter(const float* distances, float* parameters, size_t count) const;
+
+private:
+
+    size_t segments;
+    std::vector<float> coefficients;
+    std::vector<float> arc_lengths;
+
+    NEO_BATCH_FUNC_DECL void add_hermite(const T& p0, const T& m0, const T& p1, const T& m1);
+
+    template <bool Derivative>
+    void horner(const float* parameters, T* values, size_t count) const;
+
+};
+
+template <class T>
+NEO_BATCH_FUNC_DEF void spline<T>::add_hermite(const T& p0, const T& m0, const T& p1, const T& m1) {
+    T power[4] = { p0, m0, p0 * -3.0f - m0 * 2.0f + p1 * 3.0f - m1, p0 * 2.0f + m0 - p1 * 2.0f + m1 };
+    for (int p = 0; p < 4; p++) {
+        for (int c = 0; c < COMPONENTS; c++) coefficients.push_back(((const float*)&power[p])[c]);
+    }
+    segments++;
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF spline<T> spline<T>::catmull_rom(const T* points, size_t count) {
+    spline result;
+    for (size_t i = 0; i + 1 < count; i++) {
+        const T& before = points[i > 0 ? i - 1 : i];
+        const T& after = points[i + 2 < count ? i + 2 : i + 1];
+        result.add_hermite(points[i], (points[i + 1] - before) * 0.5f, points[i + 1], (after - points[i]) * 0.5f);
+    }
+    return result;
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF spline<T> spline<T>::bezier(const T* control_points, size_t count) {
+    spline result;
+    for (size_t i = 0; i + 3 < count; i += 3) {
+        const T* b = control_points + i;
+        result.add_hermite(b[0], (b[1] - b[0]) * 3.0f, b[3], (b[3] - b[2]) * 3.0f);
+    }
+    return result;
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF spline<T> spline<T>::hermite(const T* points, const T* tangents, size_t count) {
+    spline result;
+    for (size_t i = 0; i + 1 < count; i++) result.add_hermite(points[i], tangents[i], points[i + 1], tangents[i + 1]);
+    return result;
+}
+
+template <class T>
+template <bool Derivative>
+inline void spline<T>::horner(const float* parameters, T* values, size_t count) const {
+    if (segments == 0) {
+        std::fill(values, values + count, T());
+        return;
+    }
+
+    const float* segment_coefficients = coefficients.data();
+    size_t segment_count = segments;
+    parallel_for(count, 1 << 12, [&](size_t begin, size_t end) {
+        simd::dispatch<detail::spline_kernel<COMPONENTS, Derivative> >(segment_coefficients, segment_count, parameters, (float*)values, begin, end);
+    });
+}
+
+// Single parameters are evaluated in place, without going through the thread pool.
+template <class T>
+NEO_BATCH_FUNC_DEF T spline<T>::evaluate(float t) const {
+    T result = T();
+    if (segments == 0) return result;
+    float u = simd::min(simd::max(t, 0.0f), 1.0f) * (float)segments;
+    float segment = simd::min(floorf(u), (float)(segments - 1));
+    u -= segment;
+    const float* c = &coefficients[(size_t)segment * 4 * COMPONENTS];
+    for (int k = 0; k < COMPONENTS; k++) {
+        ((float*)&result)[k] = simd::fmadd(simd::fmadd(simd::fmadd(c[3 * COMPONENTS + k], u, c[2 * COMPONENTS + k]), u, c[COMPONENTS + k]), u, c[k]);
+    }
+    return result;
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF T spline<T>::derivative(float t) const {
+    T result = T();
+    if (segments == 0) return result;
+    float u = simd::min(simd::max(t, 0.0f), 1.0f) * (float)segments;
+    float segment = simd::min(floorf(u), (float)(segments - 1));
+    u -= segment;
+    const float* c = &coefficients[(size_t)segment * 4 * COMPONENTS];
+    for (int k = 0; k < COMPONENTS; k++) {
+        ((float*)&result)[k] = simd::fmadd(simd::fmadd(c[3 * COMPONENTS + k] * 3.0f, u, c[2 * COMPONENTS + k] * 2.0f), u, c[COMPONENTS + k]) * (float)segments;
+    }
+    return result;
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF void spline<T>::evaluate(const float* parameters, T* values, size_t count) const {
+    horner<false>(parameters, values, count);
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF void spline<T>::derivative(const float* parameters, T* tangents, size_t count) const {
+    horner<true>(parameters, tangents, count);
+}
+
+// Sums chord lengths between consecutive samples; every segment is tabulated independently and
+// the per-segment lengths are accumulated afterwards.
+template <class T>
+NEO_BATCH_FUNC_DEF void spline<T>::build_arc_length_table(size_t samples_per_segment) {
+    size_t steps = segments * samples_per_segment;
+    arc_lengths.assign(steps > 0 ? steps + 1 : 0, 0.0f);
+    if (steps == 0) return;
+
+    std::vector<float> parameters(steps + 1);
+    for (size_t i = 0; i <= steps; i++) parameters[i] = (float)i / (float)steps;
+    std::vector<T> points(steps + 1);
+    evaluate(parameters.data(), points.data(), steps + 1);
+
+    parallel_for(segments, 64, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; s++) {
+            float total = 0.0f;
+            for (size_t j = s * samples_per_segment; j < (s + 1) * samples_per_segment; j++) {
+                total += (points[j + 1] - points[j]).length();
+                arc_lengths[j + 1] = total;
+            }
+        }
+    });
+
+    for (size_t s = 1; s < segments; s++) {
+        float offset = arc_lengths[s * samples_per_segment];
+        for (size_t j = s * samples_per_segment + 1; j <= (s + 1) * samples_per_segment; j++) arc_lengths[j] += offset;
+    }
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF float spline<T>::parameter(float distance) const {
+    if (arc_lengths.size() < 2) return 0.0f;
+
+    size_t steps = arc_lengths.size() - 1;
+    if (distance <= 0.0f) return 0.0f;
+    if (distance >= arc_lengths[steps]) return 1.0f;
+
+    size_t upper = std::upper_bound(arc_lengths.begin(), arc_lengths.end(), distance) - arc_lengths.begin();
+    float span = arc_lengths[upper] - arc_lengths[upper - 1];
+    float fraction = span > 0.0f ? (distance - arc_lengths[upper - 1]) / span : 0.0f;
+    return ((float)(upper - 1) + fraction) / (float)steps;
+}
+
+template <class T>
+NEO_BATCH_FUNC_DEF void spline<T>::parameter(const float* distances, float* parameters, size_t count) const {
+    parallel_for(count, 1 << 12, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) parameters[i] = parameter(distances[i]);
+    });
+}
+
+}
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "neo.hpp"
+
+namespace neo {
+
+// Single-producer, single-consumer exchange of arrays through three buffers. The writer fills its
+// own buffer and publishes it by swapping it with the shared middle one; the reader swaps the
+// middle buffer for its own when a newer one was published. Neither side blocks or copies what the
+// other sees, and the reader always holds one complete publication.
+//
+// The writer may mark the ranges it changed before publishing; a publication without marks counts
+// as changing the whole array. The reader gets the ranges that differ from the snapshot it held
+// before, and the writer's next buffer is brought up to date by copying only those ranges.
+template <class T>
+class triple_buffer {
+
+public:
+
+    struct range {
+        size_t begin, end;
+    };
+
+    explicit triple_buffer(size_t count = 0);
+
+    // Writer side. write_data holds the last published values; overwrite_data skips bringing the
+    // buffer up to date and may hold older values, so every element has to be written before
+    // publishing. Resizing counts as changing the whole array.
+    T* write_data();
+    T* overwrite_data();
+    size_t write_size() const { return slots[back].values.size(); }
+    void resize(size_t count);
+    void mark(size_t begin, size_t end);
+    void publish();
+
+    // Reader side. acquire takes the latest publication, if there is one newer than the current
+    // snapshot, and returns whether the snapshot changed.
+    bool acquire();
+    const T* read_data() const { return slots[front].values.data(); }
+    size_t read_size() const { return slots[front].values.size(); }
+    // Sorted, disjoint ranges that differ between the current snapshot and the one held before
+    // the last acquire; empty if it returned false.
+    const std::vector<range>& changes() const { return *latest_changes; }
+
+private:
+
+    enum { INDEX = 3, FRESH = 4, MAX_RANGES = 64 };
+
+    // since[j] lists the ranges published after the values held in buffer j.
+    struct slot {
+        std::vector<T> values;
+        std::vector<range> since[3];
+    };
+
+    slot slots[3];
+    std::atomic<int> middle;
+
+    // Owned by the writer. missing[j] lists the ranges published since buffer j was written; the
+    // writer's buffer is refreshed from buffer source while refresh is set.
+    int back, source;
+    bool refresh, marked;
+    std::vector<range> pending, missing[3];
+
+    // Owned by the reader.
+    int front;
+    const std::vector<range>* latest_changes;
+    std::vector<range> unchanged;
+
+    triple_buffer(const triple_buffer&);
+    triple_buffer& operator=(const triple_buffer&);
+
+    static void merge(std::vector<range>& ranges, range added);
+    void update();
+
+};
+
+template <class T>
+inline triple_buffer<T>::triple_buffer(size_t count): middle(1), back(0), source(0), refresh(false), marked(false), front(2) {
+    for (int j = 0; j < 3; j++) slots[j].values.resize(count);
+    latest_changes = &unchanged;
+}
+
+// Keeps ranges sorted and coalesced; past MAX_RANGES they collapse into one covering range, which
+// bounds the bookkeeping at the price of copying more.
+template <class T>
+inline void triple_buffer<T>::merge(std::vector<range>& ranges, range added) {
+    if (added.begin >= added.end) return;
+    size_t first = 0;
+    while (first < ranges.size() && ranges[first].end < added.begin) first++;
+    size_t last = first;
+    while (last < ranges.size() && ranges[last].begin <= added.end) {
+        added.begin = std::min(added.begin, ranges[last].begin);
+        added.end = std::max(added.end, ranges[last].end);
+        last++;
+    }
+    ranges.erase(ranges.begin() + first, ranges.begin() + last);
+    ranges.insert(ranges.begin() + first, added);
+    if (ranges.size() > MAX_RANGES) {
+        range covering = { ranges.front().begin, ranges.back().end };
+        ranges.assign(1, covering);
+    }
+}
+
+template <class T>
+inline void triple_buffer<T>::update() {
+    if (!refresh) return;
+    refresh = false;
+    const std::vector<T>& from = slots[source].values;
+    std::vector<T>& to = slots[back].values;
+    to.resize(from.size());
+    for (size_t k = 0; k < missing[back].size(); k++) {
+        size_t begin = missing[back][k].begin, end = std::min(missing[back][k].end, from.size());
+        if (begin >= end) continue;
+        parallel_for(end - begin, 1 << 14, [&](size_t first, size_t last) {
+            std::copy(from.begin() + (begin + first), from.begin() + (begin + last), to.begin() + (begin + first));
+        });
+    }
+    missing[back].clear();
+}
+
+template <class T>
+inline T* triple_buffer<T>::write_data() {
+    update();
+    return slots[back].values.data();
+}
+
+template <class T>
+inline T* triple_buffer<T>::overwrite_data() {
+    if (refresh) {
+        refresh = false;
+        slots[back].values.resize(slots[source].values.size());
+        missing[back].clear();
+    }
+    return slots[back].values.data();
+}
+
+template <class T>
+inline void triple_buffer<T>::resize(size_t count) {
+    update();
+    slots[back].values.resize(count);
+    mark(0, count);
+}
+
+template <class T>
+inline void triple_buffer<T>::mark(size_t begin, size_t end) {
+    range added = { begin, end };
+    merge(pending, added);
+    marked = true;
+}
+
+template <class T>
+inline void triple_buffer<T>::publish() {
+    update();
+    if (!marked) {
+        range whole = { 0, slots[back].values.size() };
+        merge(pending, whole);
+    }
+    slot& published = slots[back];
+    for (int j = 0; j < 3; j++) {
+        if (j == back) continue;
+        for (size_t k = 0; k < pending.size(); k++) merge(missing[j], pending[k]);
+        published.since[j] = missing[j];
+    }
+    published.since[back].clear();
+    pending.clear();
+    marked = false;
+
+    source = back;
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    refresh = true;
+}
+
+template <class T>
+inline bool triple_buffer<T>::acquire() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+        latest_changes = &unchanged;
+        return false;
+    }
+    int previous = front;
+    front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+    latest_changes = &slots[front].since[previous];
+    return true;
+}
+
+}
+
+#endif